@@ -0,0 +1,22 @@
+TextureCube EnvTexture : register(t0);
+
+RWStructuredBuffer<float4> Signature : register(u0);
+
+SamplerState LinearSampler : register(s0);
+
+static const float3 FaceDirections[6] = {
+	float3(1.0, 0.0, 0.0),
+	float3(-1.0, 0.0, 0.0),
+	float3(0.0, 1.0, 0.0),
+	float3(0.0, -1.0, 0.0),
+	float3(0.0, 0.0, 1.0),
+	float3(0.0, 0.0, -1.0)
+};
+
+// The lowest mip already holds the average colour of each face
+[numthreads(6, 1, 1)] void main(uint3 ThreadID
+								: SV_DispatchThreadID) {
+	float width, height, levels;
+	EnvTexture.GetDimensions(0, width, height, levels);
+	Signature[ThreadID.x] = EnvTexture.SampleLevel(LinearSampler, FaceDirections[ThreadID.x], levels - 1);
+}
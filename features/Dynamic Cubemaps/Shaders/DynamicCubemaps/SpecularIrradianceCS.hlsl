@@ -14,6 +14,7 @@ static const float InvNumSamples = 1.0 / float(NumSamples);
 cbuffer SpecularMapFilterSettings : register(b0)
 {
 	float roughness;
+	uint faceOffset;  // First face filtered by this dispatch
 };
 
 TextureCube inputTexture : register(t0);
@@ -126,6 +127,7 @@ float3 tangentToWorld(const float3 v, const float3 N, const float3 S, const floa
 	if (ThreadID.x >= outputWidth || ThreadID.y >= outputHeight) {
 		return;
 	}
+	ThreadID.z += faceOffset;
 
 	// Get input cubemap dimensions at zero mipmap level.
 	float inputWidth, inputHeight, inputLevels;
@@ -95,6 +95,7 @@ cbuffer UpdateData : register(b1)
 {
 	float4 CameraData;
 	uint Reset;
+	uint FaceOffset;  // First face captured this frame
 }
 
 float3 WorldToView(float3 x, bool is_position = true, uint a_eyeIndex = 0)
@@ -128,6 +129,8 @@ bool IsSaturated(float2 value) { return IsSaturated(value.x) && IsSaturated(valu
 
 [numthreads(32, 32, 1)] void main(uint3 ThreadID
 								  : SV_DispatchThreadID) {
+	ThreadID.z = (ThreadID.z + FaceOffset) % 6;
+
 	float3 captureDirection = -GetSamplingVector(ThreadID, DynamicCubemap);
 	float3 viewDirection = WorldToView(captureDirection, false);
 	float2 uv = ViewToUV(viewDirection, false);
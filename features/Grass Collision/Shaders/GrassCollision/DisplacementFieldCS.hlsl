@@ -0,0 +1,63 @@
+struct StructuredCollision
+{
+	float3 centre[2];
+	float3 previousCentre[2];
+	float radius;
+};
+
+cbuffer PerFrame : register(b0)
+{
+	float4 FieldOrigin;  // xy is the camera-relative corner for the first eye, z the texel size, w the eye height
+	int2 TexelOffset;    // Movement of the field since the previous frame in texels
+	float Decay;
+	float CollisionExtrapolation;
+}
+
+#define NO_CONTACT 3.402823466e+38
+
+StructuredBuffer<StructuredCollision> collisions : register(t0);
+Texture2D<float4> PreviousField : register(t1);
+
+RWTexture2D<float4> Field : register(u0);
+
+[numthreads(8, 8, 1)] void main(uint3 dispatchThreadId
+								: SV_DispatchThreadID) {
+	uint width, height;
+	Field.GetDimensions(width, height);
+
+	// Carry the previous trail over, shifted as the field follows the player
+	int2 previousTexel = int2(dispatchThreadId.xy) + TexelOffset;
+	float4 trail = float4(0, 0, 0, NO_CONTACT);
+	if (all(previousTexel >= 0) && all(previousTexel < int2(width, height))) {
+		trail = PreviousField[previousTexel];
+		trail.xyz *= Decay;
+	}
+
+	float2 position = FieldOrigin.xy + (dispatchThreadId.xy + 0.5) * FieldOrigin.z;
+
+	// Same falloff as the per-vertex path, measured top-down, remembering the lowest contact in world space
+	float4 splat = float4(0, 0, 0, NO_CONTACT);
+	uint collisionCount, dummy;
+	collisions.GetDimensions(collisionCount, dummy);
+	for (uint i = 0; i < collisionCount; i++) {
+		StructuredCollision collision = collisions[i];
+		if (collision.radius <= 0)
+			continue;
+
+		float3 centre = lerp(collision.previousCentre[0], collision.centre[0], 1.0 + CollisionExtrapolation);
+		float2 offset = position - centre.xy;
+		float power = smoothstep(collision.radius, 0.0, length(offset));
+		if (power <= 0)
+			continue;
+
+		float3 direction = float3(offset.x, 0, 0);  // stops expanding/stretching
+		direction = abs(offset.x) > 0 ? normalize(direction) : 0;
+		float3 shift = power * direction;
+		shift.z -= power;  // bias downwards
+		splat.xyz += shift;
+		splat.w = min(splat.w, centre.z - collision.radius + FieldOrigin.w);
+	}
+
+	// Fresh contact wins over a weaker fading trail
+	Field[dispatchThreadId.xy] = dot(splat.xyz, splat.xyz) > dot(trail.xyz, trail.xyz) ? splat : trail;
+}
@@ -7,15 +7,36 @@ cbuffer GrassCollisionPerFrame : register(b5)
 	float RadiusMultiplier;
 	float DisplacementMultiplier;
 	float maxDistance;
+	uint frameInterval;
+	uint maxCollisionsPerActor;
+	bool EnableDisplacementField;
+	float CollisionExtrapolation;  // Fraction of the update interval elapsed since the last gather
+	float4 gridOrigin[2];          // xy is the grid corner, z the inverse cell size
+	float4 fieldOrigin[2];         // xy is the displacement field corner, z the inverse field extent, w the eye height
 }
 
+#define COLLISION_GRID_SIZE 16
+#define DISPLACEMENT_FIELD_SIZE 256
+#define DISPLACEMENT_FIELD_HEIGHT_BELOW_CONTACT 16.0
+#define DISPLACEMENT_FIELD_HEIGHT_ABOVE_CONTACT 128.0
+
 struct StructuredCollision
 {
 	float3 centre[2];
+	float3 previousCentre[2];
 	float radius;
 };
 
+struct CollisionCell
+{
+	uint offset;
+	uint count;
+};
+
 StructuredBuffer<StructuredCollision> collisions : register(t0);
+StructuredBuffer<CollisionCell> collisionCells : register(t1);
+StructuredBuffer<uint> collisionIndices : register(t2);
+Texture2D<float4> DisplacementField : register(t3);
 
 float3 GetDisplacedPosition(float3 position, float alpha, uint eyeIndex = 0)
 {
@@ -30,12 +51,29 @@ float3 GetDisplacedPosition(float3 position, float alpha, uint eyeIndex = 0)
 		}
 	}
 
-	if (EnableGrassCollision) {
-		uint counter = 0;
-		uint collision_count, dummy;
-		collisions.GetDimensions(collision_count, dummy);
-		for (uint collision_index = 0; collision_index < collision_count; collision_index++) {
-			StructuredCollision collision = collisions[collision_index];
+	if (EnableGrassCollision && EnableDisplacementField) {
+		float2 fieldUV = (worldPosition.xy - fieldOrigin[eyeIndex].xy) * fieldOrigin[eyeIndex].z;
+		if (any(fieldUV < 0) || any(fieldUV >= 1))
+			return 0;
+
+		float4 field = DisplacementField.Load(int3(fieldUV * DISPLACEMENT_FIELD_SIZE, 0));
+
+		// The field is top-down, ignore contact from spheres on another level such as a bridge or in the air
+		float heightAboveContact = worldPosition.z + fieldOrigin[eyeIndex].w - field.w;
+		if (heightAboveContact < -DISPLACEMENT_FIELD_HEIGHT_BELOW_CONTACT || heightAboveContact > DISPLACEMENT_FIELD_HEIGHT_ABOVE_CONTACT)
+			return 0;
+
+		displacement = field.xyz;
+	} else if (EnableGrassCollision) {
+		// Only spheres overlapping this cell can reach the vertex, everything outside the grid is out of range
+		int2 cell = floor((worldPosition.xy - gridOrigin[eyeIndex].xy) * gridOrigin[eyeIndex].z);
+		if (any(cell < 0) || any(cell >= COLLISION_GRID_SIZE))
+			return 0;
+
+		CollisionCell collisionCell = collisionCells[cell.x + cell.y * COLLISION_GRID_SIZE];
+		for (uint i = 0; i < collisionCell.count; i++) {
+			StructuredCollision collision = collisions[collisionIndices[collisionCell.offset + i]];
+			collision.centre[eyeIndex] = lerp(collision.previousCentre[eyeIndex], collision.centre[eyeIndex], 1.0 + CollisionExtrapolation);
 
 			float dist = distance(collision.centre[eyeIndex], worldPosition);
 			float power = smoothstep(collision.radius, 0.0, dist);
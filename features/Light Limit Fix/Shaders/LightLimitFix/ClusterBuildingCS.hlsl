@@ -31,20 +31,18 @@ float3 IntersectionZPlane(float3 B, float z_dist)
 	                    groupId.y * CLUSTER_BUILDING_DISPATCH_SIZE_X +
 	                    groupId.z * (CLUSTER_BUILDING_DISPATCH_SIZE_X * CLUSTER_BUILDING_DISPATCH_SIZE_Y);
 
+	uint eyeIndex = groupId.z / CLUSTER_BUILDING_DISPATCH_SIZE_Z;
+	uint clusterZ = groupId.z % CLUSTER_BUILDING_DISPATCH_SIZE_Z;
+
 	float2 clusterSize = rcp(float2(CLUSTER_BUILDING_DISPATCH_SIZE_X, CLUSTER_BUILDING_DISPATCH_SIZE_Y));
 
 	float2 texcoordMax = (groupId.xy + 1) * clusterSize;
 	float2 texcoordMin = groupId.xy * clusterSize;
-#if !defined(VR)
-	float3 maxPointVS = GetPositionVS(texcoordMax, 1.0f);
-	float3 minPointVS = GetPositionVS(texcoordMin, 1.0f);
-#else
-	float3 maxPointVS = max(GetPositionVS(texcoordMax, 1.0f, 0), GetPositionVS(texcoordMax, 1.0f, 1));
-	float3 minPointVS = min(GetPositionVS(texcoordMin, 1.0f, 0), GetPositionVS(texcoordMin, 1.0f, 1));
-#endif  // !VR
-
-	float clusterNear = LightsNear * pow(LightsFar / LightsNear, groupId.z / float(CLUSTER_BUILDING_DISPATCH_SIZE_Z));
-	float clusterFar = LightsNear * pow(LightsFar / LightsNear, (groupId.z + 1) / float(CLUSTER_BUILDING_DISPATCH_SIZE_Z));
+	float3 maxPointVS = GetPositionVS(texcoordMax, 1.0f, eyeIndex);
+	float3 minPointVS = GetPositionVS(texcoordMin, 1.0f, eyeIndex);
+
+	float clusterNear = LightsNear * pow(LightsFar / LightsNear, clusterZ / float(CLUSTER_BUILDING_DISPATCH_SIZE_Z));
+	float clusterFar = LightsNear * pow(LightsFar / LightsNear, (clusterZ + 1) / float(CLUSTER_BUILDING_DISPATCH_SIZE_Z));
 
 	float3 minPointNear = IntersectionZPlane(minPointVS, clusterNear);
 	float3 minPointFar = IntersectionZPlane(minPointVS, clusterFar);
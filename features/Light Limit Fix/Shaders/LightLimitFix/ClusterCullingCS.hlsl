@@ -7,14 +7,13 @@ StructuredBuffer<ClusterAABB> clusters : register(t0);
 StructuredBuffer<StructuredLight> lights : register(t1);
 
 RWStructuredBuffer<uint> lightIndexCounter : register(u0);  //1
-RWStructuredBuffer<uint> lightIndexList : register(u1);     //MAX_CLUSTER_LIGHTS * 16^3
-RWStructuredBuffer<LightGrid> lightGrid : register(u2);     //16^3
+RWStructuredBuffer<uint> lightIndexList : register(u1);     //MAX_CLUSTER_LIGHTS * 16^3 * eyes
+RWStructuredBuffer<LightGrid> lightGrid : register(u2);     //16^3 * eyes
 
 groupshared StructuredLight sharedLights[GROUP_SIZE];
 
-bool LightIntersectsCluster(StructuredLight light, ClusterAABB cluster, int eyeIndex = 0)
+bool LightIntersectsCluster(StructuredLight light, ClusterAABB cluster, uint eyeIndex = 0)
 {
-	// For now, only use left eye position
 	float3 closest = max(cluster.minPoint, min(light.positionVS[eyeIndex].xyz, cluster.maxPoint)).xyz;
 
 	float3 dist = closest - light.positionVS[eyeIndex].xyz;
@@ -37,6 +36,7 @@ bool LightIntersectsCluster(StructuredLight light, ClusterAABB cluster, int eyeI
 	uint visibleLightIndices[MAX_CLUSTER_LIGHTS];
 
 	uint clusterIndex = groupIndex + GROUP_SIZE * groupId.z;
+	uint eyeIndex = clusterIndex / CLUSTER_COUNT;
 
 	ClusterAABB cluster = clusters[clusterIndex];
 
@@ -58,18 +58,17 @@ bool LightIntersectsCluster(StructuredLight light, ClusterAABB cluster, int eyeI
 		GroupMemoryBarrierWithGroupSync();
 
 		for (uint i = 0; i < batchSize; i++) {
-			StructuredLight light = lights[i];
+			StructuredLight light = sharedLights[i];
 
-			if (visibleLightCount < MAX_CLUSTER_LIGHTS && (LightIntersectsCluster(light, cluster)
-#ifdef VR
-															  || LightIntersectsCluster(light, cluster, 1)
-#endif  // VR
-																  )) {
+			if (visibleLightCount < MAX_CLUSTER_LIGHTS && LightIntersectsCluster(light, cluster, eyeIndex)) {
 				visibleLightIndices[visibleLightCount] = lightOffset + i;
 				visibleLightCount++;
 			}
 		}
 
+		// Every thread has to finish reading this batch before the next one overwrites it
+		GroupMemoryBarrierWithGroupSync();
+
 		lightOffset += batchSize;
 	}
 
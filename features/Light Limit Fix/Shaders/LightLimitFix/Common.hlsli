@@ -6,6 +6,9 @@
 #define CLUSTER_BUILDING_DISPATCH_SIZE_Y 16
 #define CLUSTER_BUILDING_DISPATCH_SIZE_Z 16
 
+// Each eye has its own grid, stored one after the other
+#define CLUSTER_COUNT (CLUSTER_BUILDING_DISPATCH_SIZE_X * CLUSTER_BUILDING_DISPATCH_SIZE_Y * CLUSTER_BUILDING_DISPATCH_SIZE_Z)
+
 struct ClusterAABB
 {
 	float4 minPoint;
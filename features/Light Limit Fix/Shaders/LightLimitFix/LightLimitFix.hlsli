@@ -29,8 +29,8 @@ struct PerPassLLF
 };
 
 StructuredBuffer<StructuredLight> lights : register(t17);
-StructuredBuffer<uint> lightList : register(t18);       //MAX_CLUSTER_LIGHTS * 16^3
-StructuredBuffer<LightGrid> lightGrid : register(t19);  //16^3
+StructuredBuffer<uint> lightList : register(t18);       //MAX_CLUSTER_LIGHTS * 16^3 * eyes
+StructuredBuffer<LightGrid> lightGrid : register(t19);  //16^3 * eyes
 
 #if !defined(SCREEN_SPACE_SHADOWS)
 Texture2D<float4> TexDepthSampler : register(t20);
@@ -48,7 +48,7 @@ struct StrictLightData
 
 StructuredBuffer<StrictLightData> strictLightData : register(t37);
 
-bool GetClusterIndex(in float2 uv, in float z, out uint clusterIndex)
+bool GetClusterIndex(in float2 uv, in float z, out uint clusterIndex, uint a_eyeIndex = 0)
 {
 	if (z < perPassLLF[0].LightsNear || z > perPassLLF[0].LightsFar)
 		return false;
@@ -58,7 +58,7 @@ bool GetClusterIndex(in float2 uv, in float z, out uint clusterIndex)
 	uint2 clusterDim = ceil(perPassLLF[0].BufferDim / float2(16, 16));
 	uint3 cluster = uint3(uint2((uv * perPassLLF[0].BufferDim) / clusterDim), clusterZ);
 
-	clusterIndex = cluster.x + (16 * cluster.y) + (16 * 16 * cluster.z);
+	clusterIndex = cluster.x + (16 * cluster.y) + (16 * 16 * cluster.z) + (16 * 16 * 16 * a_eyeIndex);
 	return true;
 }
 
@@ -1,9 +1,11 @@
 RWTexture2D<float> OcclusionRW : register(u0);
+RWTexture2D<float2> HistoryRW : register(u1);
 
 SamplerState LinearSampler : register(s0);
 
 Texture2D<float> DepthTexture : register(t0);
 Texture2D<float> ShadowTexture : register(t1);
+Texture2D<float2> PreviousHistory : register(t2);  // Visibility and view depth
 
 cbuffer PerFrame : register(b0)
 {
@@ -24,8 +26,18 @@ cbuffer PerFrame : register(b0)
 	float BlurRadius;
 	float BlurDropoff;
 	bool Enabled;
+	uint RaymarchScale;  // Raymarch resolution divisor
+	bool TemporalAccumulation;
+	uint TemporalSamples;
+	float TemporalBlend;
+	float4x4 ReprojectionMatrix;  // Current view space to the previous frame's clip space
+	float FrameOffset;  // Golden ratio sequence in [0, 1) advanced every frame
+	bool HistoryValid;
 };
 
+// Relative view depth difference above which the history belongs to another surface
+static const float TemporalDepthTolerance = 0.05;
+
 bool IsSaturated(float value) { return value == saturate(value); }
 bool IsSaturated(float2 value) { return IsSaturated(value.x) && IsSaturated(value.y); }
 
@@ -98,6 +110,10 @@ float ScreenSpaceShadowsUV(float2 texcoord, float3 lightDirectionVS)
 
 	// Offset starting position with interleaved gradient noise
 	float offset = InterleavedGradientNoise(texcoord * BufferDim);
+
+	// Shift the offsets every frame so that accumulated frames sample different positions
+	if (TemporalAccumulation)
+		offset = frac(offset + FrameOffset);
 	rayPos += rayStep * offset;
 
 	float thickness = lerp(NearThickness, rayPos.z * FarThicknessScale, blendFactorFar);
@@ -144,6 +160,38 @@ float ScreenSpaceShadowsUV(float2 texcoord, float3 lightDirectionVS)
 
 [numthreads(32, 32, 1)] void main(uint3 DTid
 								  : SV_DispatchThreadID) {
-	float2 TexCoord = (DTid.xy + 0.5) * RcpBufferDim * DynamicRes.zw;
-	OcclusionRW[DTid.xy] = ScreenSpaceShadowsUV(TexCoord, InvDirLightDirectionVS);
+	// Each thread covers a block of RaymarchScale pixels and traces from its centre
+	float2 TexCoord = (DTid.xy + 0.5) * RaymarchScale * RcpBufferDim * DynamicRes.zw;
+	float visibility = ScreenSpaceShadowsUV(TexCoord, InvDirLightDirectionVS);
+
+	if (TemporalAccumulation) {
+		float2 history = float2(visibility, 0);
+
+		float startDepth = GetDepth(TexCoord);
+		if (startDepth < 1) {
+			float3 positionVS = InverseProjectUVZ(TexCoord, startDepth);
+			history.y = positionVS.z;
+
+			if (HistoryValid) {
+				float4 previousPositionCS = mul(ReprojectionMatrix, float4(positionVS, 1));
+				float2 previousUV = (previousPositionCS.xy / previousPositionCS.w) * float2(0.5, -0.5) + 0.5;
+
+				if (IsSaturated(previousUV)) {
+					uint2 historyDim;
+					PreviousHistory.GetDimensions(historyDim.x, historyDim.y);
+					uint2 historyTexel = min(uint2(previousUV * DynamicRes.xy * BufferDim / RaymarchScale), historyDim - 1);
+					float2 previous = PreviousHistory[historyTexel];
+
+					// Reject history from surfaces which were not at this depth in the previous frame
+					if (abs(previous.y - previousPositionCS.w) < previousPositionCS.w * TemporalDepthTolerance)
+						history.x = lerp(previous.x, visibility, TemporalBlend);
+				}
+			}
+		}
+
+		HistoryRW[DTid.xy] = history;
+		visibility = history.x;
+	}
+
+	OcclusionRW[DTid.xy] = visibility;
 }
\ No newline at end of file
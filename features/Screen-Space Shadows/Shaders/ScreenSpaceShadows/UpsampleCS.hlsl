@@ -0,0 +1,103 @@
+RWTexture2D<float> OcclusionRW : register(u0);
+
+SamplerState LinearSampler : register(s0);
+
+Texture2D<float> DepthTexture : register(t0);
+Texture2D<float> ShadowTexture : register(t1);
+
+cbuffer PerFrame : register(b0)
+{
+	float2 BufferDim;
+	float2 RcpBufferDim;
+	float4x4 ProjMatrix;
+	float4x4 InvProjMatrix;
+	float4 DynamicRes;
+	float4 InvDirLightDirectionVS;
+	float ShadowDistance;
+	uint MaxSamples;
+	float FarDistanceScale;
+	float FarThicknessScale;
+	float FarHardness;
+	float NearDistance;
+	float NearThickness;
+	float NearHardness;
+	float BlurRadius;
+	float BlurDropoff;
+	bool Enabled;
+	uint RaymarchScale;  // Raymarch resolution divisor
+};
+
+// Get a raw depth from the depth buffer.
+float GetDepth(float2 uv)
+{
+	return DepthTexture.SampleLevel(LinearSampler, uv * DynamicRes.xy, 0).r;
+}
+
+// Inverse project UV + raw depth into the view space.
+float3 InverseProjectUVZ(float2 uv, float z)
+{
+	uv.y = 1 - uv.y;
+	float4 cp = float4(float3(uv, z) * 2 - 1, 1);
+	float4 vp = mul(InvProjMatrix, cp);
+	return float3(vp.xy, vp.z) / vp.w;
+}
+
+float3 InverseProjectUV(float2 uv)
+{
+	return InverseProjectUVZ(uv, GetDepth(uv));
+}
+
+// Joint bilateral upsample of the reduced resolution raymarch, guided by the full resolution depth
+[numthreads(32, 32, 1)] void main(uint3 DTid
+								  : SV_DispatchThreadID) {
+	float2 TexCoord = (DTid.xy + 0.5) * RcpBufferDim * DynamicRes.zw;
+
+	// Ignore the sky
+	float startDepth = GetDepth(TexCoord);
+	if (startDepth >= 1) {
+		OcclusionRW[DTid.xy] = 1;
+		return;
+	}
+
+	float depth = InverseProjectUVZ(TexCoord, startDepth).z;
+	float depthDrop = max(depth * BlurDropoff, 1e-3);
+
+	uint2 lowResDim;
+	ShadowTexture.GetDimensions(lowResDim.x, lowResDim.y);
+
+	// The four raymarched texels surrounding this pixel
+	float2 lowResPosition = (DTid.xy + 0.5) / RaymarchScale - 0.5;
+	int2 base = floor(lowResPosition);
+	float2 fraction = lowResPosition - base;
+
+	float shadow = 0;
+	float weightSum = 0;
+	float nearestShadow = 1;
+	float nearestDelta = 1e30;
+
+	[unroll] for (uint i = 0; i < 4; i++)
+	{
+		int2 offset = int2(i & 1, i >> 1);
+		int2 texel = clamp(base + offset, 0, int2(lowResDim) - 1);
+
+		// Raymarched texels traced from the centre of their block
+		float2 texelUV = (texel + 0.5) * RaymarchScale * RcpBufferDim * DynamicRes.zw;
+		float texelDepth = InverseProjectUV(texelUV).z;
+		float texelShadow = ShadowTexture[texel];
+
+		float2 bilinear = lerp(1 - fraction, fraction, float2(offset));
+		float delta = abs(depth - texelDepth);
+		float weight = bilinear.x * bilinear.y * exp(-delta / depthDrop);
+
+		shadow += texelShadow * weight;
+		weightSum += weight;
+
+		if (delta < nearestDelta) {
+			nearestDelta = delta;
+			nearestShadow = texelShadow;
+		}
+	}
+
+	// Fall back to the closest depth match when every texel lies across an edge
+	OcclusionRW[DTid.xy] = weightSum > 1e-4 ? shadow / weightSum : nearestShadow;
+}
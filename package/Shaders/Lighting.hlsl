@@ -1754,7 +1754,7 @@ PS_OUTPUT main(PS_INPUT input, bool frontFace
 	uint clusterIndex = 0;
 
 #		if defined(LIGHT_LIMIT_FIX)
-	if (perPassLLF[0].EnableGlobalLights && GetClusterIndex(screenUV, viewPosition.z, clusterIndex)) {
+	if (perPassLLF[0].EnableGlobalLights && GetClusterIndex(screenUV, viewPosition.z, clusterIndex, eyeIndex)) {
 		lightCount = lightGrid[clusterIndex].lightCount;
 
 		if (lightCount) {
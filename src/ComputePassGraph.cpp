@@ -0,0 +1,329 @@
+#include "ComputePassGraph.h"
+
+namespace
+{
+	const void* GetResource(ID3D11View* a_view)
+	{
+		if (!a_view)
+			return nullptr;
+		ID3D11Resource* resource = nullptr;
+		a_view->GetResource(&resource);
+		// The view keeps the resource alive, only its identity is needed
+		resource->Release();
+		return resource;
+	}
+
+	bool Contains(const void* const* a_resources, uint a_count, const void* a_resource)
+	{
+		if (!a_resource)
+			return false;
+		for (uint i = 0; i < a_count; i++) {
+			if (a_resources[i] == a_resource)
+				return true;
+		}
+		return false;
+	}
+
+	ComputePassOrder::Access GetAccess(const ComputePassGraph::Pass& a_pass)
+	{
+		ComputePassOrder::Access access;
+		access.shader = a_pass.shader;
+		for (auto resource : a_pass.srvResources) {
+			if (resource)
+				access.reads.push_back(resource);
+		}
+		for (auto resource : a_pass.uavResources) {
+			if (resource)
+				access.writes.push_back(resource);
+		}
+		return access;
+	}
+
+	// Highest used slot + 1 of an array of bindings
+	template <class T, size_t N>
+	uint GetSlotCount(const T (&a_slots)[N])
+	{
+		for (uint i = (uint)N; i > 0; i--) {
+			if (a_slots[i - 1])
+				return i;
+		}
+		return 0;
+	}
+
+	// Finds the range of slots which differ from what is bound, returns false if nothing changed
+	template <class T, size_t N>
+	bool GetChangedRange(const T (&a_slots)[N], const T (&a_bound)[N], uint& a_first, uint& a_count)
+	{
+		uint first = (uint)N;
+		uint last = 0;
+		for (uint i = 0; i < (uint)N; i++) {
+			if (a_slots[i] && a_slots[i] != a_bound[i]) {
+				first = std::min(first, i);
+				last = i;
+			}
+		}
+		if (first == (uint)N)
+			return false;
+		a_first = first;
+		a_count = last - first + 1;
+		return true;
+	}
+}
+
+void ComputePassGraph::AddPass(Pass&& a_pass)
+{
+	if (passes.size() >= MAX_PASSES) {
+		logger::warn("Too many compute passes, skipping {}", a_pass.name);
+		return;
+	}
+	for (uint i = 0; i < MAX_SRVS; i++)
+		a_pass.srvResources[i] = GetResource(a_pass.srvs[i]);
+	for (uint i = 0; i < MAX_UAVS; i++)
+		a_pass.uavResources[i] = GetResource(a_pass.uavs[i]);
+	passes.push_back(std::move(a_pass));
+}
+
+bool ComputePassGraph::TimingsRequested() const
+{
+	auto frameCount = RE::BSGraphics::State::GetSingleton()->uiFrameCount;
+	return frameCount - timingsRequestedFrame <= 1;
+}
+
+void ComputePassGraph::ReadTimings()
+{
+	auto context = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context;
+
+	// Only the oldest set of queries is read, it is usually finished by now and it never stalls the CPU
+	auto& queries = timingQueries[timingIndex];
+	if (!queries.pending)
+		return;
+
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+	if (context->GetData(queries.disjoint.get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return;
+
+	queries.pending = false;
+	if (disjoint.Disjoint)
+		return;
+
+	UINT64 previous;
+	if (context->GetData(queries.timestamps[0].get(), &previous, sizeof(previous), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return;
+
+	for (size_t i = 0; i < queries.names.size(); i++) {
+		UINT64 timestamp;
+		if (context->GetData(queries.timestamps[i + 1].get(), &timestamp, sizeof(timestamp), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			return;
+		timings[queries.names[i]] = { (float)((double)(timestamp - previous) * 1000.0 / (double)disjoint.Frequency), queries.frame };
+		previous = timestamp;
+	}
+}
+
+void ComputePassGraph::Execute()
+{
+	if (passes.empty())
+		return;
+
+	auto context = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context;
+	auto device = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder;
+
+	std::vector<ComputePassOrder::Access> accesses;
+	accesses.reserve(passes.size());
+	for (auto& pass : passes)
+		accesses.push_back(GetAccess(pass));
+	auto order = ComputePassOrder::Order(accesses);
+
+	// Only the slots used by any pass are saved and restored
+	uint srvCount = 0;
+	uint uavCount = 0;
+	uint cbCount = 0;
+	uint samplerCount = 0;
+	for (auto& pass : passes) {
+		srvCount = std::max(srvCount, GetSlotCount(pass.srvs));
+		uavCount = std::max(uavCount, GetSlotCount(pass.uavs));
+		cbCount = std::max(cbCount, GetSlotCount(pass.constantBuffers));
+		samplerCount = std::max(samplerCount, GetSlotCount(pass.samplers));
+	}
+
+	struct OldState
+	{
+		ID3D11ComputeShader* shader = nullptr;
+		ID3D11ClassInstance* instances[256]{};
+		UINT numInstances = ARRAYSIZE(instances);
+		ID3D11ShaderResourceView* srvs[MAX_SRVS]{};
+		ID3D11UnorderedAccessView* uavs[MAX_UAVS]{};
+		ID3D11Buffer* constantBuffers[MAX_CONSTANT_BUFFERS]{};
+		ID3D11SamplerState* samplers[MAX_SAMPLERS]{};
+	} old{};
+
+	context->CSGetShader(&old.shader, old.instances, &old.numInstances);
+	if (srvCount)
+		context->CSGetShaderResources(0, srvCount, old.srvs);
+	if (uavCount)
+		context->CSGetUnorderedAccessViews(0, uavCount, old.uavs);
+	if (cbCount)
+		context->CSGetConstantBuffers(0, cbCount, old.constantBuffers);
+	if (samplerCount)
+		context->CSGetSamplers(0, samplerCount, old.samplers);
+
+	// Start from empty slots so nothing bound by the game conflicts with the passes
+	ID3D11ShaderResourceView* nullSrvs[MAX_SRVS]{};
+	ID3D11UnorderedAccessView* nullUavs[MAX_UAVS]{};
+	if (srvCount)
+		context->CSSetShaderResources(0, srvCount, nullSrvs);
+	if (uavCount)
+		context->CSSetUnorderedAccessViews(0, uavCount, nullUavs, nullptr);
+
+	ID3D11ComputeShader* boundShader = nullptr;
+	ID3D11ShaderResourceView* boundSrvs[MAX_SRVS]{};
+	ID3D11UnorderedAccessView* boundUavs[MAX_UAVS]{};
+	ID3D11Buffer* boundConstantBuffers[MAX_CONSTANT_BUFFERS]{};
+	ID3D11SamplerState* boundSamplers[MAX_SAMPLERS]{};
+	const void* boundSrvResources[MAX_SRVS]{};
+	const void* boundUavResources[MAX_UAVS]{};
+
+	bool timing = TimingsRequested();
+	auto& queries = timingQueries[timingIndex];
+	if (timing && queries.pending)
+		timing = false;  // Still waiting on the results from TIMING_LATENCY frames ago
+
+	if (timing) {
+		if (!queries.disjoint) {
+			D3D11_QUERY_DESC desc{ D3D11_QUERY_TIMESTAMP_DISJOINT, 0 };
+			DX::ThrowIfFailed(device->CreateQuery(&desc, queries.disjoint.put()));
+			desc.Query = D3D11_QUERY_TIMESTAMP;
+			for (auto& timestamp : queries.timestamps)
+				DX::ThrowIfFailed(device->CreateQuery(&desc, timestamp.put()));
+		}
+		queries.names.clear();
+		queries.frame = RE::BSGraphics::State::GetSingleton()->uiFrameCount;
+		context->Begin(queries.disjoint.get());
+		context->End(queries.timestamps[0].get());
+	}
+
+	for (auto index : order) {
+		auto& pass = passes[index];
+
+		// A resource cannot be bound for reading and writing at once, unbind only the slots which would conflict
+		for (uint i = 0; i < MAX_UAVS; i++) {
+			if (boundUavs[i] && pass.uavs[i] != boundUavs[i] && Contains(pass.srvResources, MAX_SRVS, boundUavResources[i])) {
+				boundUavs[i] = nullptr;
+				boundUavResources[i] = nullptr;
+				context->CSSetUnorderedAccessViews(i, 1, &boundUavs[i], nullptr);
+			}
+		}
+		for (uint i = 0; i < MAX_SRVS; i++) {
+			if (boundSrvs[i] && pass.srvs[i] != boundSrvs[i] && Contains(pass.uavResources, MAX_UAVS, boundSrvResources[i])) {
+				boundSrvs[i] = nullptr;
+				boundSrvResources[i] = nullptr;
+				context->CSSetShaderResources(i, 1, &boundSrvs[i]);
+			}
+		}
+
+		if (pass.prepare)
+			pass.prepare();
+
+		uint first, count;
+		if (GetChangedRange(pass.srvs, boundSrvs, first, count)) {
+			context->CSSetShaderResources(first, count, pass.srvs + first);
+			for (uint i = first; i < first + count; i++) {
+				boundSrvs[i] = pass.srvs[i];
+				boundSrvResources[i] = pass.srvResources[i];
+			}
+		}
+		if (GetChangedRange(pass.uavs, boundUavs, first, count)) {
+			context->CSSetUnorderedAccessViews(first, count, pass.uavs + first, nullptr);
+			for (uint i = first; i < first + count; i++) {
+				boundUavs[i] = pass.uavs[i];
+				boundUavResources[i] = pass.uavResources[i];
+			}
+		}
+		if (GetChangedRange(pass.constantBuffers, boundConstantBuffers, first, count)) {
+			context->CSSetConstantBuffers(first, count, pass.constantBuffers + first);
+			std::copy_n(pass.constantBuffers + first, count, boundConstantBuffers + first);
+		}
+		if (GetChangedRange(pass.samplers, boundSamplers, first, count)) {
+			context->CSSetSamplers(first, count, pass.samplers + first);
+			std::copy_n(pass.samplers + first, count, boundSamplers + first);
+		}
+		if (pass.shader != boundShader) {
+			context->CSSetShader(pass.shader, nullptr, 0);
+			boundShader = pass.shader;
+		}
+
+		context->Dispatch(pass.threadGroupCount[0], pass.threadGroupCount[1], pass.threadGroupCount[2]);
+
+		if (timing) {
+			context->End(queries.timestamps[queries.names.size() + 1].get());
+			queries.names.push_back(pass.name);
+		}
+	}
+
+	if (timing) {
+		context->End(queries.disjoint.get());
+		queries.pending = true;
+	}
+	timingIndex = (timingIndex + 1) % TIMING_LATENCY;
+	ReadTimings();
+
+	// Restore the game's state, unbinding the writable views first so the restored views cannot conflict with them
+	if (uavCount)
+		context->CSSetUnorderedAccessViews(0, uavCount, nullUavs, nullptr);
+	if (srvCount)
+		context->CSSetShaderResources(0, srvCount, old.srvs);
+	if (uavCount)
+		context->CSSetUnorderedAccessViews(0, uavCount, old.uavs, nullptr);
+	if (cbCount)
+		context->CSSetConstantBuffers(0, cbCount, old.constantBuffers);
+	if (samplerCount)
+		context->CSSetSamplers(0, samplerCount, old.samplers);
+	context->CSSetShader(old.shader, old.instances, old.numInstances);
+
+	for (auto srv : old.srvs) {
+		if (srv)
+			srv->Release();
+	}
+	for (auto uav : old.uavs) {
+		if (uav)
+			uav->Release();
+	}
+	for (auto buffer : old.constantBuffers) {
+		if (buffer)
+			buffer->Release();
+	}
+	for (auto sampler : old.samplers) {
+		if (sampler)
+			sampler->Release();
+	}
+	if (old.shader)
+		old.shader->Release();
+	for (uint i = 0; i < old.numInstances; i++) {
+		if (old.instances[i])
+			old.instances[i]->Release();
+	}
+
+	passes.clear();
+}
+
+void ComputePassGraph::DrawTimings()
+{
+	auto frameCount = RE::BSGraphics::State::GetSingleton()->uiFrameCount;
+	timingsRequestedFrame = frameCount;
+
+	// Passes skipped by a feature, such as mips which no longer exist after a resolution change, must not add to the total
+	std::erase_if(timings, [frameCount](const auto& a_entry) {
+		return frameCount - a_entry.second.frame > TIMING_STALE_FRAMES;
+	});
+
+	if (timings.empty()) {
+		ImGui::Text("No compute passes recorded");
+		return;
+	}
+
+	float total = 0.0f;
+	for (auto& [name, timing] : timings) {
+		ImGui::Text(std::format("{} : {:.3f} ms", name, timing.milliseconds).c_str());
+		total += timing.milliseconds;
+	}
+	ImGui::Text(std::format("Total : {:.3f} ms", total).c_str());
+}
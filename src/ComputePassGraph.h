@@ -0,0 +1,71 @@
+#pragma once
+
+#include <d3d11.h>
+
+#include "ComputePassOrder.h"
+
+// Runs a batch of compute passes recorded by a feature. Each pass declares the views it reads and writes, the batch
+// orders passes by those dependencies, saves and restores the compute state once, and only unbinds views that would
+// conflict with the next pass. GPU time per pass is measured while the menu displays it.
+class ComputePassGraph
+{
+public:
+	static constexpr uint MAX_SRVS = 8;
+	static constexpr uint MAX_UAVS = 4;
+	static constexpr uint MAX_CONSTANT_BUFFERS = 2;
+	static constexpr uint MAX_SAMPLERS = 1;
+	static constexpr uint MAX_PASSES = 32;
+	static constexpr uint TIMING_LATENCY = 3;
+
+	struct Pass
+	{
+		std::string name;
+		ID3D11ComputeShader* shader = nullptr;
+		ID3D11ShaderResourceView* srvs[MAX_SRVS]{};
+		ID3D11UnorderedAccessView* uavs[MAX_UAVS]{};
+		ID3D11Buffer* constantBuffers[MAX_CONSTANT_BUFFERS]{};
+		ID3D11SamplerState* samplers[MAX_SAMPLERS]{};
+		uint threadGroupCount[3] = { 1, 1, 1 };
+		std::function<void()> prepare;  // Runs right before the pass is bound, e.g. to update a constant buffer
+
+		// Resources behind the views above, filled in by AddPass
+		const void* srvResources[MAX_SRVS]{};
+		const void* uavResources[MAX_UAVS]{};
+	};
+
+	void AddPass(Pass&& a_pass);
+	void Execute();
+
+	// Passes which have not been measured for this many frames no longer run and are dropped from the timings
+	static constexpr uint TIMING_STALE_FRAMES = TIMING_LATENCY * 2;
+
+	struct Timing
+	{
+		float milliseconds;
+		uint32_t frame;  // Frame the pass was measured in
+	};
+
+	// GPU time of the most recently measured passes, by pass name
+	static inline std::map<std::string, Timing> timings;
+	static inline uint32_t timingsRequestedFrame = 0;
+
+	static void DrawTimings();
+
+private:
+	std::vector<Pass> passes;
+
+	struct TimingQueries
+	{
+		winrt::com_ptr<ID3D11Query> disjoint;
+		winrt::com_ptr<ID3D11Query> timestamps[MAX_PASSES + 1];
+		std::vector<std::string> names;
+		uint32_t frame = 0;
+		bool pending = false;
+	};
+
+	TimingQueries timingQueries[TIMING_LATENCY];
+	uint timingIndex = 0;
+
+	bool TimingsRequested() const;
+	void ReadTimings();
+};
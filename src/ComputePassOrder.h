@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Execution order of the passes recorded by ComputePassGraph. Only depends on the standard library and identifies
+// shaders and resources by opaque pointers, so it can be tested without a device.
+namespace ComputePassOrder
+{
+	struct Access
+	{
+		const void* shader = nullptr;
+		std::vector<const void*> reads;
+		std::vector<const void*> writes;
+	};
+
+	inline bool Contains(const std::vector<const void*>& a_resources, const void* a_resource)
+	{
+		for (auto resource : a_resources) {
+			if (resource == a_resource)
+				return true;
+		}
+		return false;
+	}
+
+	// Whether a_pass has to run after a_earlier, which is the case when either writes a resource the other one accesses
+	inline bool DependsOn(const Access& a_pass, const Access& a_earlier)
+	{
+		for (auto resource : a_earlier.writes) {
+			if (Contains(a_pass.reads, resource) || Contains(a_pass.writes, resource))
+				return true;
+		}
+		for (auto resource : a_earlier.reads) {
+			if (Contains(a_pass.writes, resource))
+				return true;
+		}
+		return false;
+	}
+
+	/*
+	 * Orders passes so that every pass runs after the earlier passes it depends on.
+	 *
+	 * <p>
+	 * Among the passes which are ready, one using the same shader as the previous pass is preferred, otherwise the
+	 * recorded order is kept.
+	 * </p>
+	 *
+	 * @param a_passes The recorded passes
+	 * @return Indices into a_passes in execution order
+	 */
+	inline std::vector<std::size_t> Order(const std::vector<Access>& a_passes)
+	{
+		auto count = a_passes.size();
+
+		std::vector<std::vector<std::size_t>> dependents(count);
+		std::vector<std::size_t> remaining(count, 0);
+		for (std::size_t i = 0; i < count; i++) {
+			for (std::size_t j = i + 1; j < count; j++) {
+				if (DependsOn(a_passes[j], a_passes[i])) {
+					dependents[i].push_back(j);
+					remaining[j]++;
+				}
+			}
+		}
+
+		std::vector<std::size_t> order;
+		order.reserve(count);
+		std::vector<bool> scheduled(count, false);
+		const void* lastShader = nullptr;
+
+		while (order.size() < count) {
+			std::size_t next = count;
+			for (std::size_t i = 0; i < count; i++) {
+				if (scheduled[i] || remaining[i])
+					continue;
+				if (next == count)
+					next = i;
+				if (lastShader && a_passes[i].shader == lastShader) {
+					next = i;
+					break;
+				}
+			}
+
+			scheduled[next] = true;
+			order.push_back(next);
+			lastShader = a_passes[next].shader;
+			for (auto dependent : dependents[next])
+				remaining[dependent]--;
+		}
+
+		return order;
+	}
+}
@@ -1,8 +1,38 @@
 #include "DynamicCubemaps.h"
+#include <State.h>
 #include <Util.h>
 
 constexpr auto MIPLEVELS = 10;
 
+static std::uint32_t GetBytesPerPixel(DXGI_FORMAT a_format)
+{
+	switch (a_format) {
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		return 16;
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+		return 8;
+	default:
+		return 4;
+	}
+}
+
+static std::uint64_t GetCubemapMemory(const D3D11_TEXTURE2D_DESC& a_desc)
+{
+	std::uint64_t size = 0;
+	for (uint level = 0; level < a_desc.MipLevels; level++)
+		size += (std::uint64_t)std::max(a_desc.Width >> level, 1u) * std::max(a_desc.Height >> level, 1u);
+	return size * a_desc.ArraySize * GetBytesPerPixel(a_desc.Format);
+}
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+	DynamicCubemaps::Settings,
+	CaptureFacesPerFrame,
+	IBLFacesPerFrame,
+	ChangeDrivenIBL,
+	IBLChangeThreshold,
+	CaptureResolution)
+
 void DynamicCubemaps::DrawSettings()
 {
 	if (ImGui::TreeNodeEx("Settings", ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -46,6 +76,86 @@ void DynamicCubemaps::DrawSettings()
 		ImGui::Checkbox("updateCapture", &updateCapture);
 		ImGui::Checkbox("updateIBL", &updateIBL);
 
+		ImGui::SliderInt("Capture Faces per Frame", (int*)&settings.CaptureFacesPerFrame, 1, 6);
+		if (ImGui::IsItemHovered()) {
+			ImGui::BeginTooltip();
+			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+			ImGui::Text("Number of cubemap faces captured from the screen each frame. Lower values spread the capture over more frames.");
+			ImGui::PopTextWrapPos();
+			ImGui::EndTooltip();
+		}
+
+		ImGui::SliderInt("Filtered Faces per Frame", (int*)&settings.IBLFacesPerFrame, 1, GetIBLFaceCount());
+		if (ImGui::IsItemHovered()) {
+			ImGui::BeginTooltip();
+			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+			ImGui::Text("Number of cubemap faces across all roughness levels prefiltered each frame. %u refreshes everything every frame.", GetIBLFaceCount());
+			ImGui::PopTextWrapPos();
+			ImGui::EndTooltip();
+		}
+
+		ImGui::Checkbox("Change-Driven Filtering", &settings.ChangeDrivenIBL);
+		if (ImGui::IsItemHovered()) {
+			ImGui::BeginTooltip();
+			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+			ImGui::Text("Only prefilters the cubemap again once the captured colours have changed. Static scenes then pay almost nothing for reflections.");
+			ImGui::PopTextWrapPos();
+			ImGui::EndTooltip();
+		}
+
+		ImGui::SliderFloat("Change Threshold", &settings.IBLChangeThreshold, 0.001f, 0.5f, "%.3f", ImGuiSliderFlags_Logarithmic);
+		if (ImGui::IsItemHovered()) {
+			ImGui::BeginTooltip();
+			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+			ImGui::Text("Relative change in the average colour of any cubemap face needed to prefilter again.");
+			ImGui::PopTextWrapPos();
+			ImGui::EndTooltip();
+		}
+
+		{
+			static constexpr uint resolutions[] = { 0, 512, 256, 128 };
+			static constexpr const char* resolutionNames[] = { "Native", "512", "256", "128" };
+
+			int current = 0;
+			for (uint i = 0; i < ARRAYSIZE(resolutions); i++)
+				if (resolutions[i] == settings.CaptureResolution)
+					current = (int)i;
+
+			if (ImGui::Combo("Capture Resolution", &current, resolutionNames, (int)ARRAYSIZE(resolutionNames)))
+				settings.CaptureResolution = resolutions[current];
+			if (ImGui::IsItemHovered()) {
+				ImGui::BeginTooltip();
+				ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+				ImGui::Text("Face size of the captured and prefiltered cubemaps. Native follows the game's reflections cubemap. Lower resolutions save memory and bandwidth at the cost of sharper reflections.");
+				ImGui::PopTextWrapPos();
+				ImGui::EndTooltip();
+			}
+		}
+
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNodeEx("Statistics", ImGuiTreeNodeFlags_DefaultOpen)) {
+		ImGui::Text(fmt::format("Capture converged: {}", captureConverged).c_str());
+		ImGui::Text(fmt::format("Filtering converged: {}", iblConverged).c_str());
+		ImGui::Text(fmt::format("Filtering progress: {}/{}", iblFace, GetIBLFaceCount()).c_str());
+		ImGui::Text(fmt::format("Capture change: {:.3f}", signatureChange).c_str());
+		ImGui::Text(fmt::format("Filtering skipped: {}", iblSkipped).c_str());
+
+		ImGui::Text(fmt::format("Capture resolution: {}x{}", envTexture->desc.Width, envTexture->desc.Height).c_str());
+		ImGui::Text(fmt::format("Capture memory: {:.2f} MB", captureMemory / (1024.0 * 1024.0)).c_str());
+		ImGui::Text(fmt::format("Reflections cubemap memory: {:.2f} MB", cubemapMemory / (1024.0 * 1024.0)).c_str());
+
+		// Captured faces and their mip chain are written every frame, inference writes the same faces of the full size
+		// reflections cubemap and filtering writes roughly a third of a face per filtered face
+		D3D11_TEXTURE2D_DESC cubemapDesc;
+		RE::BSGraphics::Renderer::GetSingleton()->GetRendererData().cubemapRenderTargets[RE::RENDER_TARGETS_CUBEMAP::kREFLECTIONS].texture->GetDesc(&cubemapDesc);
+		std::uint64_t faceSize = (std::uint64_t)envTexture->desc.Width * envTexture->desc.Height * GetBytesPerPixel(envTexture->desc.Format);
+		std::uint64_t cubemapFaceSize = (std::uint64_t)cubemapDesc.Width * cubemapDesc.Height * GetBytesPerPixel(cubemapDesc.Format);
+		uint capturedFacesPerFrame = std::clamp(settings.CaptureFacesPerFrame, 1u, 6u);
+		std::uint64_t bandwidth = capturedFacesPerFrame * (faceSize + cubemapFaceSize) + 6 * faceSize / 3 + std::min(settings.IBLFacesPerFrame, GetIBLFaceCount()) * faceSize / 3;
+		ImGui::Text(fmt::format("Estimated writes per frame: {:.2f} MB", bandwidth / (1024.0 * 1024.0)).c_str());
+
 		ImGui::TreePop();
 	}
 }
@@ -116,6 +226,10 @@ void DynamicCubemaps::ClearShaderCache()
 		specularIrradianceCS->Release();
 		specularIrradianceCS = nullptr;
 	}
+	if (signatureCS) {
+		signatureCS->Release();
+		signatureCS = nullptr;
+	}
 }
 
 ID3D11ComputeShader* DynamicCubemaps::GetComputeShaderUpdate()
@@ -145,6 +259,15 @@ ID3D11ComputeShader* DynamicCubemaps::GetComputeShaderSpecularIrradiance()
 	return specularIrradianceCS;
 }
 
+ID3D11ComputeShader* DynamicCubemaps::GetComputeShaderSignature()
+{
+	if (!signatureCS) {
+		logger::debug("Compiling CubemapSignatureCS");
+		signatureCS = (ID3D11ComputeShader*)Util::CompileShader(L"Data\\Shaders\\DynamicCubemaps\\CubemapSignatureCS.hlsl", {}, "cs_5_0");
+	}
+	return signatureCS;
+}
+
 void DynamicCubemaps::UpdateCubemapCapture()
 {
 	auto renderer = RE::BSGraphics::Renderer::GetSingleton();
@@ -156,65 +279,155 @@ void DynamicCubemaps::UpdateCubemapCapture()
 
 	auto cubemap = renderer->GetRendererData().cubemapRenderTargets[RE::RENDER_TARGETS_CUBEMAP::kREFLECTIONS];
 
-	ID3D11ShaderResourceView* srvs[2] = { depth.depthSRV, snowSwap.SRV };
-	context->CSSetShaderResources(0, 2, srvs);
-
-	ID3D11UnorderedAccessView* uav = envCaptureTexture->uav.get();
-	context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
-
-	ID3D11Buffer* buffers[2];
-	context->PSGetConstantBuffers(12, 1, buffers);
+	ID3D11Buffer* perFrame = nullptr;
+	context->PSGetConstantBuffers(12, 1, &perFrame);
+
+	// A reset has to clear every face at once, otherwise only a slice of the faces is captured this frame
+	uint faceCount = resetCapture ? 6 : std::clamp(settings.CaptureFacesPerFrame, 1u, 6u);
+	if (resetCapture) {
+		captureFace = 0;
+		capturedFaces = 0;
+		captureConverged = false;
+		iblFace = 0;
+		iblConverged = false;
+	}
 
 	UpdateCubemapCB updateData{};
 	updateData.CameraData = Util::GetCameraData();
 	updateData.Reset = resetCapture;
+	updateData.FaceOffset = captureFace;
 	updateCubemapCB->Update(updateData);
-	buffers[1] = updateCubemapCB->CB();
-
-	context->CSSetConstantBuffers(0, 2, buffers);
 
 	resetCapture = false;
 
-	context->CSSetShader(GetComputeShaderUpdate(), nullptr, 0);
-	context->Dispatch((uint32_t)std::ceil(envCaptureTexture->desc.Width / 32.0f), (uint32_t)std::ceil(envCaptureTexture->desc.Height / 32.0f), 6);
+	{
+		ComputePassGraph::Pass pass;
+		pass.name = "Dynamic Cubemaps Capture";
+		pass.shader = GetComputeShaderUpdate();
+		pass.srvs[0] = depth.depthSRV;
+		pass.srvs[1] = snowSwap.SRV;
+		pass.uavs[0] = envCaptureTexture->uav.get();
+		pass.constantBuffers[0] = perFrame;
+		pass.constantBuffers[1] = updateCubemapCB->CB();
+		pass.threadGroupCount[0] = (uint32_t)std::ceil(envCaptureTexture->desc.Width / 32.0f);
+		pass.threadGroupCount[1] = (uint32_t)std::ceil(envCaptureTexture->desc.Height / 32.0f);
+		pass.threadGroupCount[2] = faceCount;
+		passGraph.AddPass(std::move(pass));
+	}
 
-	uav = cubemapUAV;
-	context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+	// Inference fills every texel of the full size reflections cubemap, only the capture runs at the reduced size
+	D3D11_TEXTURE2D_DESC cubemapDesc;
+	cubemap.texture->GetDesc(&cubemapDesc);
 
-	context->GenerateMips(envCaptureTexture->srv.get());
+	{
+		ComputePassGraph::Pass pass;
+		pass.name = "Dynamic Cubemaps Inference";
+		pass.shader = GetComputeShaderInferrence();
+		pass.srvs[0] = envCaptureTexture->srv.get();
+		pass.uavs[0] = cubemapUAV;
+		pass.constantBuffers[0] = perFrame;
+		pass.constantBuffers[1] = updateCubemapCB->CB();
+		pass.samplers[0] = computeSampler;
+		pass.threadGroupCount[0] = (uint32_t)std::ceil(cubemapDesc.Width / 32.0f);
+		pass.threadGroupCount[1] = (uint32_t)std::ceil(cubemapDesc.Height / 32.0f);
+		pass.threadGroupCount[2] = faceCount;
+		pass.prepare = [this]() {
+			auto context = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context;
+			context->GenerateMips(envCaptureTexture->srv.get());
+		};
+		passGraph.AddPass(std::move(pass));
+	}
 
-	srvs[0] = envCaptureTexture->srv.get();
-	srvs[1] = nullptr;
-	context->CSSetShaderResources(0, 2, srvs);
+	passGraph.Execute();
 
-	context->CSSetSamplers(0, 1, &computeSampler);
+	if (perFrame)
+		perFrame->Release();
 
-	context->CSSetShader(GetComputeShaderInferrence(), nullptr, 0);
-	context->Dispatch((uint32_t)std::ceil(envCaptureTexture->desc.Width / 32.0f), (uint32_t)std::ceil(envCaptureTexture->desc.Height / 32.0f), 6);
+	captureFace = (captureFace + faceCount) % 6;
+	capturedFaces = std::min(capturedFaces + faceCount, 6u);
+	captureConverged = capturedFaces == 6;
+}
 
-	srvs[0] = nullptr;
-	context->CSSetShaderResources(0, 1, srvs);
+void DynamicCubemaps::DrawDeferred()
+{
+	auto shadowSceneNode = RE::BSShaderManager::State::GetSingleton().shadowSceneNode[0];
+	auto accumulator = RE::BSGraphics::BSShaderAccumulator::GetCurrentAccumulator();
 
-	uav = nullptr;
-	context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+	if (!activeReflections && updateCapture && shadowSceneNode == accumulator->GetRuntimeData().activeShadowSceneNode) {
+		// The capture reads the depth and colour targets and writes the reflections cubemap, which the game may have bound
+		auto& deferredState = State::GetSingleton()->deferredState;
+		deferredState.ClearRenderTargets();
+		deferredState.ClearPSShaderResources(0, StateTracker::MAX_SRVS);
 
-	buffers[0] = nullptr;
-	buffers[1] = nullptr;
-	context->CSSetConstantBuffers(0, 2, buffers);
+		UpdateCubemapCapture();
+	}
+}
 
-	context->CSSetShader(nullptr, nullptr, 0);
+void DynamicCubemaps::AddSignaturePass(ID3D11ShaderResourceView* a_cubemap)
+{
+	ComputePassGraph::Pass pass;
+	pass.name = "Dynamic Cubemaps Signature";
+	pass.shader = GetComputeShaderSignature();
+	pass.srvs[0] = a_cubemap;
+	pass.uavs[0] = signatureBuffer->uav.get();
+	pass.samplers[0] = computeSampler;
+	passGraph.AddPass(std::move(pass));
+}
 
-	ID3D11SamplerState* nullSampler = nullptr;
-	context->CSSetSamplers(0, 1, &nullSampler);
+void DynamicCubemaps::QueueSignatureReadback()
+{
+	auto renderer = RE::BSGraphics::Renderer::GetSingleton();
+	auto device = renderer->GetRuntimeData().forwarder;
+	auto context = renderer->GetRuntimeData().context;
+
+	auto& target = signatureReadback[signatureReadbackIndex];
+	if (!target) {
+		D3D11_BUFFER_DESC desc{};
+		desc.Usage = D3D11_USAGE_STAGING;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		desc.ByteWidth = signatureBuffer->desc.ByteWidth;
+		DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, target.put()));
+	}
+	context->CopyResource(target.get(), signatureBuffer->resource.get());
+	signatureReadbackPending[signatureReadbackIndex] = true;
+
+	signatureReadbackIndex = (signatureReadbackIndex + 1) % SIGNATURE_READBACK_LATENCY;
 }
 
-void DynamicCubemaps::DrawDeferred()
+bool DynamicCubemaps::CaptureChanged()
 {
-	auto shadowSceneNode = RE::BSShaderManager::State::GetSingleton().shadowSceneNode[0];
-	auto accumulator = RE::BSGraphics::BSShaderAccumulator::GetCurrentAccumulator();
+	auto context = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context;
 
-	if (!activeReflections && updateCapture && shadowSceneNode == accumulator->GetRuntimeData().activeShadowSceneNode)
-		UpdateCubemapCapture();
+	// Until filtering has converged on a complete capture it keeps running regardless of the signature
+	bool changed = !iblConverged;
+
+	// The oldest copy in the ring is read without stalling on the GPU, it is overwritten by this frame's signature next
+	auto& source = signatureReadback[signatureReadbackIndex];
+	if (!signatureReadbackPending[signatureReadbackIndex])
+		return changed;
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	if (FAILED(context->Map(source.get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped)))
+		return changed;
+
+	std::array<float4, 6> signature;
+	memcpy(signature.data(), mapped.pData, sizeof(signature));
+	context->Unmap(source.get(), 0);
+	signatureReadbackPending[signatureReadbackIndex] = false;
+
+	signatureChange = 0.0f;
+	for (uint face = 0; face < 6; face++) {
+		float3 current = { signature[face].x, signature[face].y, signature[face].z };
+		float3 previous = { filteredSignature[face].x, filteredSignature[face].y, filteredSignature[face].z };
+		float luminance = previous.Dot({ 0.2125f, 0.7154f, 0.0721f });
+		signatureChange = std::max(signatureChange, (current - previous).Length() / std::max(luminance, 0.01f));
+	}
+
+	changed |= signatureChange > settings.IBLChangeThreshold;
+	if (changed)
+		filteredSignature = signature;
+
+	return changed;
 }
 
 void DynamicCubemaps::UpdateCubemap()
@@ -229,56 +442,79 @@ void DynamicCubemaps::UpdateCubemap()
 		context->PSSetShaderResources(64, 2, views);
 	}
 
-	{
-		// Copy cubemap to other resources
-		auto cubemap = renderer->GetRendererData().cubemapRenderTargets[RE::RENDER_TARGETS_CUBEMAP::kREFLECTIONS];
+	auto cubemap = renderer->GetRendererData().cubemapRenderTargets[RE::RENDER_TARGETS_CUBEMAP::kREFLECTIONS];
 
+	// Each filtering pass reads a snapshot of the whole mip chain taken when it starts, so that all of its slices agree
+	// even though the capture keeps updating the reflections cubemap in between
+	bool signature = false;
+	if (iblFace == 0) {
 		context->GenerateMips(cubemap.SRV);
 
-		for (uint face = 0; face < 6; face++) {
-			uint srcSubresourceIndex = D3D11CalcSubresource(0, face, MIPLEVELS);
-			context->CopySubresourceRegion(envTexture->resource.get(), D3D11CalcSubresource(0, face, MIPLEVELS), 0, 0, 0, cubemap.texture, srcSubresourceIndex, nullptr);
+		iblSkipped = false;
+		if (settings.ChangeDrivenIBL) {
+			AddSignaturePass(cubemap.SRV);
+			signature = true;
+			iblSkipped = !CaptureChanged();
 		}
 
-		// Compute pre-filtered specular environment map.
-		{
-			auto srv = cubemap.SRV;
-			context->CSSetShaderResources(0, 1, &srv);
-			context->CSSetSamplers(0, 1, &computeSampler);
-			context->CSSetShader(GetComputeShaderSpecularIrradiance(), nullptr, 0);
-
-			ID3D11Buffer* buffers[1];
-			buffers[0] = spmapCB->CB();
-			context->CSSetConstantBuffers(0, ARRAYSIZE(buffers), buffers);
-
-			float const delta_roughness = 1.0f / std::max(float(MIPLEVELS - 1), 1.0f);
-
-			std::uint32_t size = std::max(envTexture->desc.Width, envTexture->desc.Height);
-
-			for (std::uint32_t level = 1; level < MIPLEVELS; level++, size /= 2) {
-				const UINT numGroups = (UINT)std::max(1u, size / 32);
+		if (!iblSkipped) {
+			for (uint face = 0; face < 6; face++) {
+				for (uint level = 0; level < envSnapshotTexture->desc.MipLevels; level++) {
+					uint srcSubresourceIndex = D3D11CalcSubresource(captureMip + level, face, MIPLEVELS);
+					context->CopySubresourceRegion(envSnapshotTexture->resource.get(), D3D11CalcSubresource(level, face, envSnapshotTexture->desc.MipLevels), 0, 0, 0, cubemap.texture, srcSubresourceIndex, nullptr);
+				}
 
-				const SpecularMapFilterSettingsCB spmapConstants = { level * delta_roughness };
-				spmapCB->Update(spmapConstants);
+				// Roughness zero is the capture itself
+				context->CopySubresourceRegion(envTexture->resource.get(), D3D11CalcSubresource(0, face, envTexture->desc.MipLevels), 0, 0, 0, envSnapshotTexture->resource.get(), D3D11CalcSubresource(0, face, envSnapshotTexture->desc.MipLevels), nullptr);
+			}
+		}
+	}
 
-				auto uav = uavArray[level - 1].get();
+	// Compute pre-filtered specular environment map.
+	if (!iblSkipped) {
+		float const delta_roughness = 1.0f / std::max(float(MIPLEVELS - 1), 1.0f);
+
+		std::uint32_t size = std::max(envTexture->desc.Width, envTexture->desc.Height);
+
+		// Filter the next faces in level order, a pass never continues into the next snapshot within one frame
+		uint iblFaceCount = GetIBLFaceCount();
+		uint remainingFaces = std::min(std::clamp(settings.IBLFacesPerFrame, 1u, iblFaceCount), iblFaceCount - iblFace);
+		while (remainingFaces > 0) {
+			std::uint32_t level = iblFace / 6 + 1;
+			uint face = iblFace % 6;
+			uint faceCount = std::min(remainingFaces, 6 - face);
+
+			const UINT numGroups = (UINT)std::max(1u, ((size >> level) + 31) / 32);
+
+			const SpecularMapFilterSettingsCB spmapConstants = { level * delta_roughness, face };
+
+			ComputePassGraph::Pass pass;
+			pass.name = fmt::format("Dynamic Cubemaps Specular Mip {}", level);
+			pass.shader = GetComputeShaderSpecularIrradiance();
+			pass.srvs[0] = envSnapshotTexture->srv.get();
+			pass.uavs[0] = uavArray[level - 1].get();
+			pass.constantBuffers[0] = spmapCB->CB();
+			pass.samplers[0] = computeSampler;
+			pass.threadGroupCount[0] = numGroups;
+			pass.threadGroupCount[1] = numGroups;
+			pass.threadGroupCount[2] = faceCount;
+			pass.prepare = [this, spmapConstants]() { spmapCB->Update(spmapConstants); };
+			passGraph.AddPass(std::move(pass));
+
+			iblFace += faceCount;
+			remainingFaces -= faceCount;
+		}
 
-				context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
-				context->Dispatch(numGroups, numGroups, 6);
-			}
+		if (iblFace == iblFaceCount) {
+			iblFace = 0;
+			iblConverged = captureConverged;
 		}
 	}
 
-	ID3D11ShaderResourceView* nullSRV = { nullptr };
-	ID3D11SamplerState* nullSampler = { nullptr };
-	ID3D11Buffer* nullBuffer = { nullptr };
-	ID3D11UnorderedAccessView* nullUAV = { nullptr };
+	passGraph.Execute();
 
-	context->CSSetShaderResources(0, 1, &nullSRV);
-	context->CSSetSamplers(0, 1, &nullSampler);
-	context->CSSetShader(nullptr, 0, 0);
-	context->CSSetConstantBuffers(0, 1, &nullBuffer);
-	context->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+	if (signature)
+		QueueSignatureReadback();
 }
 
 void DynamicCubemaps::Draw(const RE::BSShader* shader, const uint32_t)
@@ -303,6 +539,38 @@ void DynamicCubemaps::Draw(const RE::BSShader* shader, const uint32_t)
 	}
 }
 
+bool DynamicCubemaps::LoadBRDFLUT()
+{
+	constexpr auto path = "Data\\Shaders\\DynamicCubemaps\\BRDFLUT.bin";
+
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream) {
+		logger::warn("[DC] {} not found, computing the BRDF LUT instead", path);
+		return false;
+	}
+
+	BRDFLUTHeader header{};
+	stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!stream || std::memcmp(header.magic, "BRDF", sizeof(header.magic)) || header.version != BRDF_LUT_VERSION || header.width != spBRDFLUT->desc.Width || header.height != spBRDFLUT->desc.Height) {
+		logger::warn("[DC] {} is invalid, computing the BRDF LUT instead", path);
+		return false;
+	}
+
+	// Two half floats per texel, matching DXGI_FORMAT_R16G16_FLOAT
+	std::vector<std::uint16_t> texels(header.width * header.height * 2);
+	stream.read(reinterpret_cast<char*>(texels.data()), texels.size() * sizeof(std::uint16_t));
+	if (!stream) {
+		logger::warn("[DC] {} is truncated, computing the BRDF LUT instead", path);
+		return false;
+	}
+
+	auto context = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context;
+	context->UpdateSubresource(spBRDFLUT->resource.get(), 0, nullptr, texels.data(), header.width * 2 * sizeof(std::uint16_t), 0);
+
+	logger::debug("[DC] Loaded BRDF LUT from {}", path);
+	return true;
+}
+
 void DynamicCubemaps::SetupResources()
 {
 	auto renderer = RE::BSGraphics::Renderer::GetSingleton();
@@ -322,8 +590,6 @@ void DynamicCubemaps::SetupResources()
 	}
 
 	{
-		spBRDFProgram = (ID3D11ComputeShader*)Util::CompileShader(L"Data\\Shaders\\DynamicCubemaps\\SpbrdfCS.hlsl", {}, "cs_5_0");
-
 		D3D11_TEXTURE2D_DESC texDesc{};
 		texDesc.Width = 256;
 		texDesc.Height = 256;
@@ -348,7 +614,9 @@ void DynamicCubemaps::SetupResources()
 		srvDesc.Texture2D.MipLevels = 1;
 		spBRDFLUT->CreateSRV(srvDesc);
 
-		{
+		if (!LoadBRDFLUT()) {
+			spBRDFProgram = (ID3D11ComputeShader*)Util::CompileShader(L"Data\\Shaders\\DynamicCubemaps\\SpbrdfCS.hlsl", {}, "cs_5_0");
+
 			// Compute Cook-Torrance BRDF 2D LUT for split-sum approximation.
 			auto uav = spBRDFLUT->uav.get();
 			context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
@@ -405,13 +673,9 @@ void DynamicCubemaps::SetupResources()
 		uavDesc.Texture2DArray.ArraySize = texDesc.ArraySize;
 		DX::ThrowIfFailed(device->CreateUnorderedAccessView(cubemap.texture, &uavDesc, &cubemapUAV));
 
-		envTexture = new Texture2D(texDesc);
-		envTexture->CreateSRV(srvDesc);
-		envTexture->CreateUAV(uavDesc);
+		cubemapMemory = GetCubemapMemory(texDesc);
 
-		envCaptureTexture = new Texture2D(texDesc);
-		envCaptureTexture->CreateSRV(srvDesc);
-		envCaptureTexture->CreateUAV(uavDesc);
+		CreateCaptureResources();
 
 		updateCubemapCB = new ConstantBuffer(ConstantBufferDesc<UpdateCubemapCB>());
 	}
@@ -421,44 +685,115 @@ void DynamicCubemaps::SetupResources()
 	}
 
 	{
-		D3D11_TEXTURE2D_DESC texDesc{};
-		cubemap.texture->GetDesc(&texDesc);
-		texDesc.MipLevels = 1;
-		texDesc.SampleDesc.Count = 1;
-		texDesc.Usage = D3D11_USAGE_DEFAULT;
-		texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_RENDER_TARGET;
-		texDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
+		signatureBuffer = new Buffer(StructuredBufferDesc<float4>(6));
+
+		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+		uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+		uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+		uavDesc.Buffer.FirstElement = 0;
+		uavDesc.Buffer.NumElements = 6;
+		signatureBuffer->CreateUAV(uavDesc);
+	}
+}
+
+void DynamicCubemaps::CreateCaptureResources()
+{
+	auto renderer = RE::BSGraphics::Renderer::GetSingleton();
+	auto device = renderer->GetRuntimeData().forwarder;
 
-		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
-		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
-		srvDesc.TextureCube.MostDetailedMip = 0;
-		srvDesc.TextureCube.MipLevels = 1;
+	auto& cubemap = renderer->GetRendererData().cubemapRenderTargets[RE::RENDER_TARGETS_CUBEMAP::kREFLECTIONS];
 
-		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-		uavDesc.Format = envTexture->desc.Format;
-		uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2DARRAY;
+	D3D11_TEXTURE2D_DESC texDesc;
+	cubemap.texture->GetDesc(&texDesc);
 
-		uavDesc.Texture2DArray.FirstArraySlice = 0;
-		uavDesc.Texture2DArray.ArraySize = envTexture->desc.ArraySize;
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+	cubemap.SRV->GetDesc(&srvDesc);
 
-		for (std::uint32_t level = 1; level < MIPLEVELS; ++level) {
-			uavDesc.Texture2DArray.MipSlice = level;
-			DX::ThrowIfFailed(device->CreateUnorderedAccessView(envTexture->resource.get(), &uavDesc, uavArray[level - 1].put()));
-		}
+	captureResolution = settings.CaptureResolution;
+
+	// Start from the largest mip of the reflections cubemap that fits, so the filtering source can still be copied directly
+	captureMip = 0;
+	if (settings.CaptureResolution)
+		while (captureMip + 1 < MIPLEVELS && (texDesc.Width >> (captureMip + 1)) >= settings.CaptureResolution)
+			captureMip++;
+
+	texDesc.Width >>= captureMip;
+	texDesc.Height >>= captureMip;
+	texDesc.MipLevels = std::min((uint)MIPLEVELS, (uint)std::bit_width(std::max(texDesc.Width, texDesc.Height)));
+	srvDesc.TextureCube.MipLevels = texDesc.MipLevels;
+
+	D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+	uavDesc.Format = texDesc.Format;
+	uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2DARRAY;
+	uavDesc.Texture2DArray.MipSlice = 0;
+	uavDesc.Texture2DArray.FirstArraySlice = 0;
+	uavDesc.Texture2DArray.ArraySize = texDesc.ArraySize;
+
+	delete envTexture;
+	envTexture = new Texture2D(texDesc);
+	envTexture->CreateSRV(srvDesc);
+	envTexture->CreateUAV(uavDesc);
+
+	delete envCaptureTexture;
+	envCaptureTexture = new Texture2D(texDesc);
+	envCaptureTexture->CreateSRV(srvDesc);
+	envCaptureTexture->CreateUAV(uavDesc);
+
+	// The filtering source, the reflections cubemap from captureMip down. Its mip chain ends with the cubemap's own.
+	{
+		D3D11_TEXTURE2D_DESC snapshotDesc = texDesc;
+		snapshotDesc.MipLevels = std::min(texDesc.MipLevels, (uint)MIPLEVELS - captureMip);
+		snapshotDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		snapshotDesc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC snapshotSrvDesc = srvDesc;
+		snapshotSrvDesc.TextureCube.MostDetailedMip = 0;
+		snapshotSrvDesc.TextureCube.MipLevels = snapshotDesc.MipLevels;
+
+		delete envSnapshotTexture;
+		envSnapshotTexture = new Texture2D(snapshotDesc);
+		envSnapshotTexture->CreateSRV(snapshotSrvDesc);
 	}
+
+	for (auto& uav : uavArray)
+		uav = nullptr;
+
+	for (std::uint32_t level = 1; level < texDesc.MipLevels; ++level) {
+		uavDesc.Texture2DArray.MipSlice = level;
+		DX::ThrowIfFailed(device->CreateUnorderedAccessView(envTexture->resource.get(), &uavDesc, uavArray[level - 1].put()));
+	}
+
+	captureMemory = GetCubemapMemory(envTexture->desc) + GetCubemapMemory(envCaptureTexture->desc) + GetCubemapMemory(envSnapshotTexture->desc);
+
+	// Everything has to be captured and filtered again at the new resolution
+	resetCapture = true;
+	iblFace = 0;
+	iblConverged = false;
 }
 
 void DynamicCubemaps::Reset()
 {
 	activeReflections = false;
 	renderedScreenCamera = false;
+
+	// The resolution can change from the menu or by reloading the config
+	if (envTexture && captureResolution != settings.CaptureResolution)
+		CreateCaptureResources();
 }
 
 void DynamicCubemaps::Load(json& o_json)
 {
+	if (o_json[GetName()].is_object())
+		settings = o_json[GetName()];
+
+	// Only the resolutions offered in the menu are supported, snap anything else down to one of them
+	if (settings.CaptureResolution)
+		settings.CaptureResolution = std::bit_floor(std::clamp(settings.CaptureResolution, 128u, 512u));
+
 	Feature::Load(o_json);
 }
 
-void DynamicCubemaps::Save(json&)
+void DynamicCubemaps::Save(json& o_json)
 {
+	o_json[GetName()] = settings;
 }
\ No newline at end of file
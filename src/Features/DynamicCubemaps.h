@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Buffer.h"
+#include "ComputePassGraph.h"
 #include "Feature.h"
 
 class MenuOpenCloseEventHandler : public RE::BSTEventSink<RE::MenuOpenCloseEvent>
@@ -21,6 +22,17 @@ public:
 
 	bool renderedScreenCamera = false;
 
+	struct Settings
+	{
+		uint CaptureFacesPerFrame = 1;
+		uint IBLFacesPerFrame = 6;
+		bool ChangeDrivenIBL = true;
+		float IBLChangeThreshold = 0.05f;
+		uint CaptureResolution = 0;  // Face size in texels, 0 follows the reflections cubemap
+	};
+
+	Settings settings;
+
 	// Specular irradiance
 
 	ID3D11SamplerState* computeSampler = nullptr;
@@ -28,26 +40,42 @@ public:
 	struct alignas(16) SpecularMapFilterSettingsCB
 	{
 		float roughness;
-		float pad[3];
+		uint faceOffset;
+		float pad[2];
 	};
 
 	ID3D11ComputeShader* specularIrradianceCS = nullptr;
 	ConstantBuffer* spmapCB = nullptr;
 	Texture2D* envTexture = nullptr;
+	Texture2D* envSnapshotTexture = nullptr;  // Source of the current filtering pass, copied when it starts
 	winrt::com_ptr<ID3D11UnorderedAccessView> uavArray[9];
 
 	// BRDF 2D LUT
 
+	// Generated offline by tools/BRDFLUTGenerator, SpbrdfCS is only compiled when the file is missing or invalid
+	struct BRDFLUTHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t width;
+		std::uint32_t height;
+	};
+
+	static constexpr std::uint32_t BRDF_LUT_VERSION = 1;
+
 	ID3D11ComputeShader* spBRDFProgram = nullptr;
 	Texture2D* spBRDFLUT = nullptr;
 
+	bool LoadBRDFLUT();
+
 	// Reflection capture
 
 	struct alignas(16) UpdateCubemapCB
 	{
 		float4 CameraData;
 		uint Reset;
-		float pad[3];
+		uint FaceOffset;
+		float pad[2];
 	};
 
 	ID3D11ComputeShader* updateCubemapCS = nullptr;
@@ -56,6 +84,14 @@ public:
 	ID3D11ComputeShader* inferCubemapCS = nullptr;
 	Texture2D* envCaptureTexture = nullptr;
 
+	// The capture can run below the resolution of the reflections cubemap, starting from one of its mips
+	uint captureResolution = 0;
+	uint captureMip = 0;
+	std::uint64_t captureMemory = 0;
+	std::uint64_t cubemapMemory = 0;
+
+	void CreateCaptureResources();
+
 	bool activeReflections = false;
 
 	bool resetCapture = true;
@@ -63,8 +99,35 @@ public:
 	bool updateCapture = true;
 	bool updateIBL = true;
 
+	// Capture and filtering are spread over several frames, each frame continuing where the previous one stopped
+	uint GetIBLFaceCount() const { return 6 * (envTexture->desc.MipLevels - 1); }  // Every face of every filtered mip level
+
+	uint captureFace = 0;
+	uint capturedFaces = 0;
+	uint iblFace = 0;
+	bool captureConverged = false;
+	bool iblConverged = false;
+
+	// Filtering only restarts once the capture has visibly changed, judged by the average colour of each face
+	static constexpr uint SIGNATURE_READBACK_LATENCY = 3;
+
+	ID3D11ComputeShader* signatureCS = nullptr;
+	Buffer* signatureBuffer = nullptr;
+	winrt::com_ptr<ID3D11Buffer> signatureReadback[SIGNATURE_READBACK_LATENCY];
+	bool signatureReadbackPending[SIGNATURE_READBACK_LATENCY]{};
+	uint signatureReadbackIndex = 0;
+	std::array<float4, 6> filteredSignature{};
+	float signatureChange = 0.0f;
+	bool iblSkipped = false;
+
+	void AddSignaturePass(ID3D11ShaderResourceView* a_cubemap);
+	void QueueSignatureReadback();
+	bool CaptureChanged();
+
 	ID3D11UnorderedAccessView* cubemapUAV;
 
+	ComputePassGraph passGraph;
+
 	void UpdateCubemap();
 
 	virtual inline std::string GetName() { return "Dynamic Cubemaps"; }
@@ -101,6 +164,7 @@ public:
 	ID3D11ComputeShader* GetComputeShaderUpdate();
 	ID3D11ComputeShader* GetComputeShaderInferrence();
 	ID3D11ComputeShader* GetComputeShaderSpecularIrradiance();
+	ID3D11ComputeShader* GetComputeShaderSignature();
 
 	void UpdateCubemapCapture();
 
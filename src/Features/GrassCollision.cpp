@@ -1,5 +1,8 @@
 #include "GrassCollision.h"
 
+#include <execution>
+#include <numeric>
+
 #include "State.h"
 #include "Util.h"
 
@@ -7,7 +10,9 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
 	GrassCollision::Settings,
 	EnableGrassCollision,
 	RadiusMultiplier,
-	DisplacementMultiplier)
+	DisplacementMultiplier,
+	maxCollisionsPerActor,
+	EnableDisplacementField)
 
 enum class GrassShaderTechniques
 {
@@ -66,6 +71,24 @@ void GrassCollision::DrawSettings()
 			ImGui::EndTooltip();
 		}
 
+		ImGui::SliderInt("Max Collisions per Actor", (int*)&settings.maxCollisionsPerActor, 0, 64);
+		if (ImGui::IsItemHovered()) {
+			ImGui::BeginTooltip();
+			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+			ImGui::Text("Maximum number of collision shapes gathered from each actor. 0 means no limit.");
+			ImGui::PopTextWrapPos();
+			ImGui::EndTooltip();
+		}
+
+		ImGui::Checkbox("Enable Trampled Trails", (bool*)&settings.EnableDisplacementField);
+		if (ImGui::IsItemHovered()) {
+			ImGui::BeginTooltip();
+			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+			ImGui::Text("Splats collisions into a displacement map around the player which fades over time, leaving trampled trails. Grass cost no longer depends on the number of collisions.");
+			ImGui::PopTextWrapPos();
+			ImGui::EndTooltip();
+		}
+
 		ImGui::TreePop();
 	}
 	if (ImGui::TreeNodeEx("Statistics", ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -75,48 +98,56 @@ void GrassCollision::DrawSettings()
 	}
 }
 
-static bool GetShapeBound(RE::NiAVObject* a_node, RE::NiPoint3& centerPos, float& radius)
+float GrassCollision::GetShapeRadius(const RE::hkpShape* a_shape)
 {
-	RE::bhkNiCollisionObject* Colliedobj = nullptr;
-	if (a_node->collisionObject)
-		Colliedobj = a_node->collisionObject->AsBhkNiCollisionObject();
-
-	if (!Colliedobj)
-		return false;
+	auto frameCount = RE::BSGraphics::State::GetSingleton()->uiFrameCount;
 
-	RE::bhkRigidBody* bhkRigid = Colliedobj->body.get() ? Colliedobj->body.get()->AsBhkRigidBody() : nullptr;
-	RE::hkpRigidBody* hkpRigid = bhkRigid ? skyrim_cast<RE::hkpRigidBody*>(bhkRigid->referencedObject.get()) : nullptr;
-	if (bhkRigid && hkpRigid) {
-		RE::hkVector4 massCenter;
-		bhkRigid->GetCenterOfMassWorld(massCenter);
-		float massTrans[4];
-		_mm_store_ps(massTrans, massCenter.quad);
-		centerPos = RE::NiPoint3(massTrans[0], massTrans[1], massTrans[2]) * RE::bhkWorld::GetWorldScaleInverse();
+	// The local-space extents of a shape never change, so only the six projections of new shapes are evaluated
+	{
+		std::shared_lock lock(shapeRadiusCacheMutex);
+		if (auto it = shapeRadiusCache.find(a_shape); it != shapeRadiusCache.end()) {
+			std::atomic_ref(it->second.lastUsedFrame).store(frameCount, std::memory_order_relaxed);
+			return it->second.radius;
+		}
+	}
 
-		const RE::hkpShape* shape = hkpRigid->collidable.GetShape();
-		if (shape) {
-			float upExtent = shape->GetMaximumProjection(RE::hkVector4{ 0.0f, 0.0f, 1.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			float downExtent = shape->GetMaximumProjection(RE::hkVector4{ 0.0f, 0.0f, -1.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			auto z_extent = (upExtent + downExtent) / 2.0f;
+	float upExtent = a_shape->GetMaximumProjection(RE::hkVector4{ 0.0f, 0.0f, 1.0f, 0.0f });
+	float downExtent = a_shape->GetMaximumProjection(RE::hkVector4{ 0.0f, 0.0f, -1.0f, 0.0f });
+	auto z_extent = (upExtent + downExtent) / 2.0f;
 
-			float forwardExtent = shape->GetMaximumProjection(RE::hkVector4{ 0.0f, 1.0f, 0.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			float backwardExtent = shape->GetMaximumProjection(RE::hkVector4{ 0.0f, -1.0f, 0.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			auto y_extent = (forwardExtent + backwardExtent) / 2.0f;
+	float forwardExtent = a_shape->GetMaximumProjection(RE::hkVector4{ 0.0f, 1.0f, 0.0f, 0.0f });
+	float backwardExtent = a_shape->GetMaximumProjection(RE::hkVector4{ 0.0f, -1.0f, 0.0f, 0.0f });
+	auto y_extent = (forwardExtent + backwardExtent) / 2.0f;
 
-			float leftExtent = shape->GetMaximumProjection(RE::hkVector4{ 1.0f, 0.0f, 0.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			float rightExtent = shape->GetMaximumProjection(RE::hkVector4{ -1.0f, 0.0f, 0.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			auto x_extent = (leftExtent + rightExtent) / 2.0f;
+	float leftExtent = a_shape->GetMaximumProjection(RE::hkVector4{ 1.0f, 0.0f, 0.0f, 0.0f });
+	float rightExtent = a_shape->GetMaximumProjection(RE::hkVector4{ -1.0f, 0.0f, 0.0f, 0.0f });
+	auto x_extent = (leftExtent + rightExtent) / 2.0f;
 
-			radius = sqrtf(x_extent * x_extent + y_extent * y_extent + z_extent * z_extent);
+	float radius = sqrtf(x_extent * x_extent + y_extent * y_extent + z_extent * z_extent) * RE::bhkWorld::GetWorldScaleInverse();
+	std::unique_lock lock(shapeRadiusCacheMutex);
+	// Holding a reference keeps the shape alive, so its address cannot be reused by another shape while cached
+	if (shapeRadiusCache.insert({ a_shape, { radius, frameCount } }).second)
+		a_shape->AddReference();
+	return radius;
+}
 
-			return true;
-		}
-	}
+void GrassCollision::PruneShapeRadiusCache()
+{
+	// Cached shapes are kept alive by the cache, so release the ones that have not been seen recently
+	auto frameCount = RE::BSGraphics::State::GetSingleton()->uiFrameCount;
+	if (frameCount % SHAPE_RADIUS_CACHE_PRUNE_INTERVAL != 0)
+		return;
 
-	return false;
+	std::unique_lock lock(shapeRadiusCacheMutex);
+	std::erase_if(shapeRadiusCache, [frameCount](const auto& a_entry) {
+		if (frameCount - a_entry.second.lastUsedFrame <= SHAPE_RADIUS_CACHE_PRUNE_INTERVAL)
+			return false;
+		a_entry.first->RemoveReference();
+		return true;
+	});
 }
 
-static bool GetShapeBound(RE::bhkNiCollisionObject* Colliedobj, RE::NiPoint3& centerPos, float& radius)
+bool GrassCollision::GetShapeBound(RE::bhkNiCollisionObject* Colliedobj, RE::NiPoint3& centerPos, float& radius)
 {
 	if (!Colliedobj)
 		return false;
@@ -132,20 +163,7 @@ static bool GetShapeBound(RE::bhkNiCollisionObject* Colliedobj, RE::NiPoint3& ce
 
 		const RE::hkpShape* shape = hkpRigid->collidable.GetShape();
 		if (shape) {
-			float upExtent = shape->GetMaximumProjection(RE::hkVector4{ 0.0f, 0.0f, 1.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			float downExtent = shape->GetMaximumProjection(RE::hkVector4{ 0.0f, 0.0f, -1.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			auto z_extent = (upExtent + downExtent) / 2.0f;
-
-			float forwardExtent = shape->GetMaximumProjection(RE::hkVector4{ 0.0f, 1.0f, 0.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			float backwardExtent = shape->GetMaximumProjection(RE::hkVector4{ 0.0f, -1.0f, 0.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			auto y_extent = (forwardExtent + backwardExtent) / 2.0f;
-
-			float leftExtent = shape->GetMaximumProjection(RE::hkVector4{ 1.0f, 0.0f, 0.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			float rightExtent = shape->GetMaximumProjection(RE::hkVector4{ -1.0f, 0.0f, 0.0f, 0.0f }) * RE::bhkWorld::GetWorldScaleInverse();
-			auto x_extent = (leftExtent + rightExtent) / 2.0f;
-
-			radius = sqrtf(x_extent * x_extent + y_extent * y_extent + z_extent * z_extent);
-
+			radius = GetShapeRadius(shape);
 			return true;
 		}
 	}
@@ -153,18 +171,21 @@ static bool GetShapeBound(RE::bhkNiCollisionObject* Colliedobj, RE::NiPoint3& ce
 	return false;
 }
 
+// Collisions that moved further than this between gathers are treated as teleported and not extrapolated
+static constexpr float MAX_COLLISION_MOVEMENT = 512.0f;
+
 void GrassCollision::UpdateCollisions()
 {
 	auto state = RE::BSGraphics::RendererShadowState::GetSingleton();
 
 	auto frameCount = RE::BSGraphics::State::GetSingleton()->uiFrameCount;
 
-	if (settings.frameInterval == 0 || frameCount % settings.frameInterval == 0) {  // only calculate actor positions on some frames
-		currentCollisionCount = 0;
+	bool gatherCollisions = settings.frameInterval == 0 || frameCount % settings.frameInterval == 0;
+	if (gatherCollisions) {  // only calculate actor positions on some frames
 		totalActorCount = 0;
 		activeActorCount = 0;
 		actorList.clear();
-		collisionsData.clear();
+		collisionsWorldData.clear();
 		// actor query code from po3 under MIT
 		// https://github.com/powerof3/PapyrusExtenderSSE/blob/7a73b47bc87331bec4e16f5f42f2dbc98b66c3a7/include/Papyrus/Functions/Faction.h#L24C7-L46
 		if (const auto processLists = RE::ProcessLists::GetSingleton(); processLists && settings.maxDistance > 0.0f) {
@@ -187,43 +208,93 @@ void GrassCollision::UpdateCollisions()
 			playerPosition = player->GetPosition();
 		}
 
+		std::vector<RE::NiAVObject*> activeRoots;
 		for (const auto actor : actorList) {
 			if (auto root = actor->Get3D(false)) {
 				if (playerPosition.GetDistance(actor->GetPosition()) > settings.maxDistance) {  // npc too far so skip
 					continue;
 				}
-				activeActorCount++;
-				RE::BSVisit::TraverseScenegraphCollision(root, [&](RE::bhkNiCollisionObject* a_object) -> RE::BSVisit::BSVisitControl {
-					RE::NiPoint3 centerPos;
-					float radius;
-					if (GetShapeBound(a_object, centerPos, radius)) {
-						radius *= settings.RadiusMultiplier;
-						CollisionSData data{};
-						RE::NiPoint3 eyePosition{};
-						for (int eyeIndex = 0; eyeIndex < eyeCount; eyeIndex++) {
-							if (!REL::Module::IsVR()) {
-								eyePosition = state->GetRuntimeData().posAdjust.getEye();
-							} else
-								eyePosition = state->GetVRRuntimeData().posAdjust.getEye(eyeIndex);
-							data.centre[eyeIndex].x = centerPos.x - eyePosition.x;
-							data.centre[eyeIndex].y = centerPos.y - eyePosition.y;
-							data.centre[eyeIndex].z = centerPos.z - eyePosition.z;
-						}
-						data.radius = radius;
-						currentCollisionCount++;
-						collisionsData.push_back(data);
-					}
-					return RE::BSVisit::BSVisitControl::kContinue;
-				});
+				activeRoots.push_back(root);
 			}
 		}
+		activeActorCount = (std::uint32_t)activeRoots.size();
+
+		// Each actor is traversed as its own job into its own buffer, so no job touches shared output
+		actorCollisions.resize(activeRoots.size());
+		std::vector<std::size_t> actorIndices(activeRoots.size());
+		std::iota(actorIndices.begin(), actorIndices.end(), 0);
+		std::for_each(std::execution::par, actorIndices.begin(), actorIndices.end(), [&](std::size_t a_index) {
+			auto& actorData = actorCollisions[a_index];
+			actorData.clear();
+			RE::BSVisit::TraverseScenegraphCollision(activeRoots[a_index], [&](RE::bhkNiCollisionObject* a_object) -> RE::BSVisit::BSVisitControl {
+				RE::NiPoint3 centerPos;
+				float radius;
+				if (GetShapeBound(a_object, centerPos, radius)) {
+					actorData.push_back({ a_object, centerPos, centerPos, radius * settings.RadiusMultiplier });
+					if (settings.maxCollisionsPerActor && actorData.size() >= settings.maxCollisionsPerActor)
+						return RE::BSVisit::BSVisitControl::kStop;
+				}
+				return RE::BSVisit::BSVisitControl::kContinue;
+			});
+		});
+
+		// Prefix sum over the per-actor counts gives each actor its slice of the merged array
+		std::vector<std::size_t> actorOffsets(activeRoots.size());
+		std::size_t totalCollisions = 0;
+		for (std::size_t i = 0; i < actorCollisions.size(); i++) {
+			actorOffsets[i] = totalCollisions;
+			totalCollisions += actorCollisions[i].size();
+		}
+
+		collisionsWorldData.resize(totalCollisions);
+		std::for_each(std::execution::par, actorIndices.begin(), actorIndices.end(), [&](std::size_t a_index) {
+			std::copy(actorCollisions[a_index].begin(), actorCollisions[a_index].end(), collisionsWorldData.begin() + actorOffsets[a_index]);
+		});
+
+		// Pair each collision with where it was at the previous gather, ignoring teleports
+		for (auto& collision : collisionsWorldData) {
+			if (auto it = previousCollisionCentres.find(collision.key); it != previousCollisionCentres.end() && it->second.GetDistance(collision.centre) < MAX_COLLISION_MOVEMENT)
+				collision.previousCentre = it->second;
+		}
+
+		previousCollisionCentres.clear();
+		for (const auto& collision : collisionsWorldData)
+			previousCollisionCentres.insert({ collision.key, collision.centre });
+
+		lastCollisionUpdateFrame = frameCount;
+		BinCollisions();
+	}
+
+	// Skipped frames extrapolate along the movement between the last two gathers
+	collisionExtrapolation = settings.frameInterval ? std::min((float)(frameCount - lastCollisionUpdateFrame) / (float)settings.frameInterval, 1.0f) : 0.0f;
+
+	RE::NiPoint3 eyePositions[2]{};
+	for (int eyeIndex = 0; eyeIndex < eyeCount; eyeIndex++) {
+		if (!REL::Module::IsVR()) {
+			eyePositions[eyeIndex] = state->GetRuntimeData().posAdjust.getEye();
+		} else
+			eyePositions[eyeIndex] = state->GetVRRuntimeData().posAdjust.getEye(eyeIndex);
 	}
-	if (!currentCollisionCount) {
+
+	collisionsData.resize(collisionsWorldData.size());
+	for (std::size_t i = 0; i < collisionsWorldData.size(); i++) {
+		const auto& collision = collisionsWorldData[i];
+		auto& data = collisionsData[i];
+		for (int eyeIndex = 0; eyeIndex < eyeCount; eyeIndex++) {
+			auto centre = collision.centre - eyePositions[eyeIndex];
+			auto previousCentre = collision.previousCentre - eyePositions[eyeIndex];
+			data.centre[eyeIndex] = { centre.x, centre.y, centre.z };
+			data.previousCentre[eyeIndex] = { previousCentre.x, previousCentre.y, previousCentre.z };
+		}
+		data.radius = collision.radius;
+	}
+
+	if (collisionsData.empty()) {
 		CollisionSData data{};
 		ZeroMemory(&data, sizeof(data));
 		collisionsData.push_back(data);
-		currentCollisionCount = 1;
 	}
+	currentCollisionCount = (std::uint32_t)collisionsData.size();
 
 	bool collisionCountChanged = currentCollisionCount != colllisionCount;
 
@@ -247,12 +318,210 @@ void GrassCollision::UpdateCollisions()
 		collisions->CreateSRV(srvDesc);
 	}
 
+	PruneShapeRadiusCache();
+
 	auto context = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context;
 	D3D11_MAPPED_SUBRESOURCE mapped;
 	DX::ThrowIfFailed(context->Map(collisions->resource.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
 	size_t bytes = sizeof(CollisionSData) * colllisionCount;
 	memcpy_s(mapped.pData, bytes, collisionsData.data(), bytes);
 	context->Unmap(collisions->resource.get(), 0);
+
+	UploadCollisionGrid();
+
+	if (settings.EnableDisplacementField)
+		UpdateDisplacementField();
+	else
+		displacementFieldValid = false;
+}
+
+ID3D11ComputeShader* GrassCollision::GetDisplacementFieldCS()
+{
+	if (!displacementFieldCS) {
+		logger::debug("Compiling DisplacementFieldCS");
+		displacementFieldCS = (ID3D11ComputeShader*)Util::CompileShader(L"Data\\Shaders\\GrassCollision\\DisplacementFieldCS.hlsl", {}, "cs_5_0");
+	}
+	return displacementFieldCS;
+}
+
+RE::NiPoint3 GrassCollision::GetDisplacementFieldOrigin() const
+{
+	return { displacementFieldTexel[0] * DISPLACEMENT_FIELD_TEXEL_SIZE, displacementFieldTexel[1] * DISPLACEMENT_FIELD_TEXEL_SIZE, 0.0f };
+}
+
+void GrassCollision::UpdateDisplacementField()
+{
+	auto player = RE::PlayerCharacter::GetSingleton();
+	if (!player)
+		return;
+
+	// Snap the field to whole texels around the player so the previous frame can be reused by an integer offset
+	auto playerPosition = player->GetPosition();
+	float halfExtent = DISPLACEMENT_FIELD_SIZE * DISPLACEMENT_FIELD_TEXEL_SIZE * 0.5f;
+	std::int32_t texel[2] = {
+		(std::int32_t)std::floor((playerPosition.x - halfExtent) / DISPLACEMENT_FIELD_TEXEL_SIZE),
+		(std::int32_t)std::floor((playerPosition.y - halfExtent) / DISPLACEMENT_FIELD_TEXEL_SIZE)
+	};
+
+	DisplacementFieldCB data{};
+	if (displacementFieldValid) {
+		data.texelOffset[0] = texel[0] - displacementFieldTexel[0];
+		data.texelOffset[1] = texel[1] - displacementFieldTexel[1];
+	} else {
+		data.texelOffset[0] = data.texelOffset[1] = (std::int32_t)DISPLACEMENT_FIELD_SIZE;  // Nothing to carry over
+	}
+	displacementFieldTexel[0] = texel[0];
+	displacementFieldTexel[1] = texel[1];
+	displacementFieldValid = true;
+
+	static float* g_deltaTime = (float*)RELOCATION_ID(523660, 410199).address();  // 2F6B948, 30064C8
+	data.decay = RE::UI::GetSingleton()->GameIsPaused() ? 1.0f : DisplacementField::GetDecay(*g_deltaTime, DISPLACEMENT_FIELD_HALF_LIFE);
+	data.collisionExtrapolation = collisionExtrapolation;
+
+	auto state = RE::BSGraphics::RendererShadowState::GetSingleton();
+	auto eyePosition = !REL::Module::IsVR() ? state->GetRuntimeData().posAdjust.getEye() : state->GetVRRuntimeData().posAdjust.getEye(0);
+	auto origin = GetDisplacementFieldOrigin();
+	data.fieldOrigin = { origin.x - eyePosition.x, origin.y - eyePosition.y, DISPLACEMENT_FIELD_TEXEL_SIZE, eyePosition.z };
+	displacementFieldCB->Update(data);
+
+	auto context = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context;
+	auto& previousField = displacementField[displacementFieldIndex];
+	displacementFieldIndex = 1 - displacementFieldIndex;
+	auto& field = displacementField[displacementFieldIndex];
+
+	ID3D11ShaderResourceView* views[2] = { collisions->srv.get(), previousField->srv.get() };
+	context->CSSetShaderResources(0, ARRAYSIZE(views), views);
+
+	ID3D11UnorderedAccessView* uav = field->uav.get();
+	context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+
+	ID3D11Buffer* buffer = displacementFieldCB->CB();
+	context->CSSetConstantBuffers(0, 1, &buffer);
+
+	context->CSSetShader(GetDisplacementFieldCS(), nullptr, 0);
+	context->Dispatch(DISPLACEMENT_FIELD_SIZE / 8, DISPLACEMENT_FIELD_SIZE / 8, 1);
+	context->CSSetShader(nullptr, nullptr, 0);
+
+	ID3D11ShaderResourceView* nullViews[2]{};
+	context->CSSetShaderResources(0, ARRAYSIZE(nullViews), nullViews);
+	ID3D11UnorderedAccessView* nullUav = nullptr;
+	context->CSSetUnorderedAccessViews(0, 1, &nullUav, nullptr);
+	ID3D11Buffer* nullBuffer = nullptr;
+	context->CSSetConstantBuffers(0, 1, &nullBuffer);
+}
+
+void GrassCollision::BinCollisions()
+{
+	// Fit the grid to the world-space top-down extents of every sphere, padded by how far it can be extrapolated
+	auto getReach = [](const CollisionWorldData& a_collision) {
+		return a_collision.radius + a_collision.centre.GetDistance(a_collision.previousCentre);
+	};
+
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	for (const auto& collision : collisionsWorldData) {
+		float reach = getReach(collision);
+		minX = std::min(minX, collision.centre.x - reach);
+		minY = std::min(minY, collision.centre.y - reach);
+		maxX = std::max(maxX, collision.centre.x + reach);
+		maxY = std::max(maxY, collision.centre.y + reach);
+	}
+
+	if (collisionsWorldData.empty())
+		minX = minY = maxX = maxY = 0.0f;
+
+	float cellSize = std::max(std::max(maxX - minX, maxY - minY) / (float)COLLISION_GRID_SIZE, 1.0f);
+	float invCellSize = 1.0f / cellSize;
+
+	gridOriginWS = { minX, minY, invCellSize, 0.0f };
+
+	auto getCellRange = [&](const CollisionWorldData& a_collision, std::uint32_t& x0, std::uint32_t& y0, std::uint32_t& x1, std::uint32_t& y1) {
+		auto toCell = [&](float a_value, float a_min) {
+			return (std::uint32_t)std::clamp((int)std::floor((a_value - a_min) * invCellSize), 0, (int)COLLISION_GRID_SIZE - 1);
+		};
+		float reach = getReach(a_collision);
+		x0 = toCell(a_collision.centre.x - reach, minX);
+		x1 = toCell(a_collision.centre.x + reach, minX);
+		y0 = toCell(a_collision.centre.y - reach, minY);
+		y1 = toCell(a_collision.centre.y + reach, minY);
+	};
+
+	// Counting sort: count spheres per cell, prefix sum into offsets, then scatter the indices
+	collisionCellsData.assign(COLLISION_GRID_SIZE * COLLISION_GRID_SIZE, {});
+	for (const auto& collision : collisionsWorldData) {
+		std::uint32_t x0, y0, x1, y1;
+		getCellRange(collision, x0, y0, x1, y1);
+		for (std::uint32_t y = y0; y <= y1; y++)
+			for (std::uint32_t x = x0; x <= x1; x++)
+				collisionCellsData[x + y * COLLISION_GRID_SIZE].count++;
+	}
+
+	std::uint32_t offset = 0;
+	for (auto& cell : collisionCellsData) {
+		cell.offset = offset;
+		offset += cell.count;
+		cell.count = 0;
+	}
+
+	collisionIndicesData.resize(std::max(offset, 1u));
+	for (std::uint32_t i = 0; i < collisionsWorldData.size(); i++) {
+		std::uint32_t x0, y0, x1, y1;
+		getCellRange(collisionsWorldData[i], x0, y0, x1, y1);
+		for (std::uint32_t y = y0; y <= y1; y++) {
+			for (std::uint32_t x = x0; x <= x1; x++) {
+				auto& cell = collisionCellsData[x + y * COLLISION_GRID_SIZE];
+				collisionIndicesData[cell.offset + cell.count++] = i;
+			}
+		}
+	}
+
+	collisionGridChanged = true;
+}
+
+void GrassCollision::UploadCollisionGrid()
+{
+	if (!collisionGridChanged)
+		return;
+	collisionGridChanged = false;
+
+	auto createBuffer = [](std::uint32_t a_stride, std::uint32_t a_count) {
+		D3D11_BUFFER_DESC sbDesc{};
+		sbDesc.Usage = D3D11_USAGE_DYNAMIC;
+		sbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		sbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		sbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		sbDesc.StructureByteStride = a_stride;
+		sbDesc.ByteWidth = a_stride * a_count;
+		auto buffer = std::make_unique<Buffer>(sbDesc);
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.FirstElement = 0;
+		srvDesc.Buffer.NumElements = a_count;
+		buffer->CreateSRV(srvDesc);
+		return buffer;
+	};
+
+	if (!collisionCells)
+		collisionCells = createBuffer(sizeof(CollisionCell), COLLISION_GRID_SIZE * COLLISION_GRID_SIZE);
+
+	// Grow geometrically so crowds don't recreate the index buffer every update
+	if (!collisionIndices || collisionIndicesData.size() > collisionIndexCapacity) {
+		collisionIndexCapacity = std::max((std::uint32_t)collisionIndicesData.size(), collisionIndexCapacity * 2);
+		collisionIndices = createBuffer(sizeof(std::uint32_t), collisionIndexCapacity);
+	}
+
+	auto context = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context;
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	DX::ThrowIfFailed(context->Map(collisionCells->resource.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+	size_t bytes = sizeof(CollisionCell) * collisionCellsData.size();
+	memcpy_s(mapped.pData, bytes, collisionCellsData.data(), bytes);
+	context->Unmap(collisionCells->resource.get(), 0);
+
+	DX::ThrowIfFailed(context->Map(collisionIndices->resource.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+	bytes = sizeof(std::uint32_t) * collisionIndicesData.size();
+	memcpy_s(mapped.pData, bytes, collisionIndicesData.data(), bytes);
+	context->Unmap(collisionIndices->resource.get(), 0);
 }
 
 void GrassCollision::ModifyGrass(const RE::BSShader*, const uint32_t)
@@ -282,10 +551,16 @@ void GrassCollision::ModifyGrass(const RE::BSShader*, const uint32_t)
 			perFrameData.boundCentre[eyeIndex].y = bound.center.y - eyePosition.y;
 			perFrameData.boundCentre[eyeIndex].z = bound.center.z - eyePosition.z;
 			perFrameData.boundCentre[eyeIndex].w = 0.0f;
+
+			perFrameData.gridOrigin[eyeIndex] = { gridOriginWS.x - eyePosition.x, gridOriginWS.y - eyePosition.y, gridOriginWS.z, 0.0f };
+
+			auto fieldOrigin = GetDisplacementFieldOrigin();
+			perFrameData.fieldOrigin[eyeIndex] = { fieldOrigin.x - eyePosition.x, fieldOrigin.y - eyePosition.y, 1.0f / (DISPLACEMENT_FIELD_SIZE * DISPLACEMENT_FIELD_TEXEL_SIZE), eyePosition.z };
 		}
 		perFrameData.boundRadius = bound.radius * settings.RadiusMultiplier;
 
 		perFrameData.Settings = settings;
+		perFrameData.collisionExtrapolation = collisionExtrapolation;
 
 		perFrame->Update(perFrameData);
 
@@ -295,8 +570,11 @@ void GrassCollision::ModifyGrass(const RE::BSShader*, const uint32_t)
 	if (settings.EnableGrassCollision) {
 		auto context = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context;
 
-		ID3D11ShaderResourceView* views[1]{};
+		ID3D11ShaderResourceView* views[4]{};
 		views[0] = collisions->srv.get();
+		views[1] = collisionCells->srv.get();
+		views[2] = collisionIndices->srv.get();
+		views[3] = displacementField[displacementFieldIndex]->srv.get();
 		context->VSSetShaderResources(0, ARRAYSIZE(views), views);
 
 		ID3D11Buffer* buffers[1];
@@ -330,6 +608,44 @@ void GrassCollision::Save(json& o_json)
 void GrassCollision::SetupResources()
 {
 	perFrame = new ConstantBuffer(ConstantBufferDesc<PerFrame>());
+	displacementFieldCB = new ConstantBuffer(ConstantBufferDesc<DisplacementFieldCB>());
+
+	D3D11_TEXTURE2D_DESC texDesc{};
+	texDesc.Width = DISPLACEMENT_FIELD_SIZE;
+	texDesc.Height = DISPLACEMENT_FIELD_SIZE;
+	texDesc.MipLevels = 1;
+	texDesc.ArraySize = 1;
+	texDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;  // Alpha holds a world space height, too large for half precision
+	texDesc.SampleDesc.Count = 1;
+	texDesc.Usage = D3D11_USAGE_DEFAULT;
+	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+	srvDesc.Format = texDesc.Format;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MipLevels = 1;
+
+	D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+	uavDesc.Format = texDesc.Format;
+	uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+
+	for (auto& field : displacementField) {
+		field = new Texture2D(texDesc);
+		field->CreateSRV(srvDesc);
+		field->CreateUAV(uavDesc);
+	}
+
+	// Start from an empty grid, the first gather can be several frames away when a frame interval is set
+	BinCollisions();
+	UploadCollisionGrid();
+}
+
+void GrassCollision::ClearShaderCache()
+{
+	if (displacementFieldCS) {
+		displacementFieldCS->Release();
+		displacementFieldCS = nullptr;
+	}
 }
 
 void GrassCollision::Reset()
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <shared_mutex>
+
 #include "Buffer.h"
 #include "Feature.h"
+#include "Features/GrassCollision/DisplacementField.h"
 
 struct GrassCollision : Feature
 {
@@ -24,38 +27,119 @@ struct GrassCollision : Feature
 		float DisplacementMultiplier = 16;
 		float maxDistance = 1000.0;
 		std::uint32_t frameInterval = 0;
+		std::uint32_t maxCollisionsPerActor = 0;
+		std::uint32_t EnableDisplacementField = 0;
 	};
 
+	static constexpr std::uint32_t COLLISION_GRID_SIZE = 16;
+
 	struct alignas(16) PerFrame
 	{
 		Vector4 boundCentre[2];
 		float boundRadius;
 		Settings Settings;
-		float pad01[2];
+		float collisionExtrapolation;  // Fraction of the update interval elapsed since the last gather
+		float pad02[3];
+		Vector4 gridOrigin[2];   // xy is the grid corner, z the inverse cell size
+		Vector4 fieldOrigin[2];  // xy is the displacement field corner, z the inverse field extent, w the eye height
 	};
 
 	struct CollisionSData
 	{
 		Vector3 centre[2];
+		Vector3 previousCentre[2];
+		float radius;
+	};
+
+	// World-space collisions from the last gather, converted to camera-relative every frame
+	struct CollisionWorldData
+	{
+		const void* key;
+		RE::NiPoint3 centre;
+		RE::NiPoint3 previousCentre;
 		float radius;
 	};
 
+	struct CollisionCell
+	{
+		std::uint32_t offset;
+		std::uint32_t count;
+	};
+
 	std::unique_ptr<Buffer> collisions = nullptr;
 	std::uint32_t totalActorCount = 0;
 	std::uint32_t activeActorCount = 0;
 	std::uint32_t currentCollisionCount = 0;
 	std::vector<RE::Actor*> actorList{};
 	std::vector<CollisionSData> collisionsData{};
+	std::vector<CollisionWorldData> collisionsWorldData{};
+	std::vector<std::vector<CollisionWorldData>> actorCollisions{};
+	std::unordered_map<const void*, RE::NiPoint3> previousCollisionCentres{};
+	std::uint32_t lastCollisionUpdateFrame = 0;
+	float collisionExtrapolation = 0.0f;
 	std::uint32_t colllisionCount = 0;
 
+	// Collisions binned into a top-down grid so each grass vertex only tests the spheres overlapping its cell
+	std::unique_ptr<Buffer> collisionCells = nullptr;
+	std::unique_ptr<Buffer> collisionIndices = nullptr;
+	std::uint32_t collisionIndexCapacity = 0;
+	std::vector<CollisionCell> collisionCellsData{};
+	std::vector<std::uint32_t> collisionIndicesData{};
+	Vector4 gridOriginWS{};  // xy is the world-space grid corner, z the inverse cell size
+	bool collisionGridChanged = false;
+
+	void BinCollisions();
+	void UploadCollisionGrid();
+
+	static constexpr std::uint32_t SHAPE_RADIUS_CACHE_PRUNE_INTERVAL = 1024;
+
+	struct CachedShapeRadius
+	{
+		float radius;
+		std::uint32_t lastUsedFrame;
+	};
+
+	// Each cached shape holds a reference until it is pruned
+	std::shared_mutex shapeRadiusCacheMutex;
+	std::unordered_map<const RE::hkpShape*, CachedShapeRadius> shapeRadiusCache;
+
+	float GetShapeRadius(const RE::hkpShape* a_shape);
+	void PruneShapeRadiusCache();
+	bool GetShapeBound(RE::bhkNiCollisionObject* Colliedobj, RE::NiPoint3& centerPos, float& radius);
+
 	Settings settings;
 
 	bool updatePerFrame = false;
 	ConstantBuffer* perFrame = nullptr;
 	int eyeCount = !REL::Module::IsVR() ? 1 : 2;
 
+	// Top-down displacement around the player, splatted from the collisions each frame and decayed over time
+	static constexpr std::uint32_t DISPLACEMENT_FIELD_SIZE = 256;
+	static constexpr float DISPLACEMENT_FIELD_TEXEL_SIZE = 8.0f;
+	static constexpr float DISPLACEMENT_FIELD_HALF_LIFE = 2.0f;  // Seconds for a trail to fade to half strength
+
+	struct alignas(16) DisplacementFieldCB
+	{
+		Vector4 fieldOrigin;  // xy is the camera-relative corner for the first eye, z the texel size, w the eye height
+		std::int32_t texelOffset[2];
+		float decay;
+		float collisionExtrapolation;
+	};
+
+	Texture2D* displacementField[2]{};
+	std::uint32_t displacementFieldIndex = 0;
+	std::int32_t displacementFieldTexel[2]{};
+	bool displacementFieldValid = false;
+	ConstantBuffer* displacementFieldCB = nullptr;
+	ID3D11ComputeShader* displacementFieldCS = nullptr;
+
+	ID3D11ComputeShader* GetDisplacementFieldCS();
+	void UpdateDisplacementField();
+	RE::NiPoint3 GetDisplacementFieldOrigin() const;
+
 	virtual void SetupResources();
 	virtual void Reset();
+	virtual void ClearShaderCache() override;
 
 	virtual void DrawSettings();
 	void UpdateCollisions();
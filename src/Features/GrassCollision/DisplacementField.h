@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+
+// CPU reference of the splat and decay in DisplacementFieldCS.hlsl and the height test in GrassCollision.hlsli.
+// Only depends on the standard library so it can be tested without the game, keep it in sync with the shaders.
+namespace DisplacementField
+{
+	// Grass this far below or above the contact height ignores the texel, so spheres on a bridge or in the air do not
+	// flatten the grass underneath
+	constexpr float HEIGHT_BELOW_CONTACT = 16.0f;
+	constexpr float HEIGHT_ABOVE_CONTACT = 128.0f;
+
+	// Texels without contact, never within range of any grass
+	constexpr float NO_CONTACT = FLT_MAX;
+
+	struct Float3
+	{
+		float x, y, z;
+	};
+
+	struct Sphere
+	{
+		Float3 centre;  // World space
+		float radius;
+	};
+
+	struct Texel
+	{
+		Float3 displacement;
+		float contactHeight = NO_CONTACT;  // Lowest bottom of the spheres which displaced the texel, world space
+	};
+
+	inline float Smoothstep(float a_edge0, float a_edge1, float a_x)
+	{
+		float t = std::clamp((a_x - a_edge0) / (a_edge1 - a_edge0), 0.0f, 1.0f);
+		return t * t * (3.0f - 2.0f * t);
+	}
+
+	// Fraction of a trail left after a_deltaTime seconds
+	inline float GetDecay(float a_deltaTime, float a_halfLife)
+	{
+		return std::exp2(-a_deltaTime / a_halfLife);
+	}
+
+	// Same falloff as the per-vertex path, measured top-down and pushing sideways along x only
+	inline Float3 Splat(const Sphere& a_sphere, float a_x, float a_y)
+	{
+		float offsetX = a_x - a_sphere.centre.x;
+		float offsetY = a_y - a_sphere.centre.y;
+		float power = Smoothstep(a_sphere.radius, 0.0f, std::sqrt(offsetX * offsetX + offsetY * offsetY));
+		float direction = offsetX > 0.0f ? 1.0f : (offsetX < 0.0f ? -1.0f : 0.0f);
+		return { power * direction, 0.0f, -power };  // bias downwards
+	}
+
+	// The texel at a_x, a_y after one update: fresh contact wins over a weaker fading trail
+	inline Texel Update(const Texel& a_previous, float a_decay, const Sphere* a_spheres, std::size_t a_count, float a_x, float a_y)
+	{
+		Texel trail = a_previous;
+		trail.displacement = { a_previous.displacement.x * a_decay, a_previous.displacement.y * a_decay, a_previous.displacement.z * a_decay };
+
+		Texel splat;
+		splat.displacement = { 0.0f, 0.0f, 0.0f };
+		for (std::size_t i = 0; i < a_count; i++) {
+			if (a_spheres[i].radius <= 0.0f)
+				continue;
+
+			auto shift = Splat(a_spheres[i], a_x, a_y);
+			if (shift.z == 0.0f)
+				continue;
+
+			splat.displacement.x += shift.x;
+			splat.displacement.y += shift.y;
+			splat.displacement.z += shift.z;
+			splat.contactHeight = std::min(splat.contactHeight, a_spheres[i].centre.z - a_spheres[i].radius);
+		}
+
+		auto lengthSquared = [](const Float3& a_vector) {
+			return a_vector.x * a_vector.x + a_vector.y * a_vector.y + a_vector.z * a_vector.z;
+		};
+		return lengthSquared(splat.displacement) > lengthSquared(trail.displacement) ? splat : trail;
+	}
+
+	// Whether grass at a_height is affected by a texel with the given contact height
+	inline bool IsInContactRange(float a_height, float a_contactHeight)
+	{
+		float heightAboveContact = a_height - a_contactHeight;
+		return heightAboveContact >= -HEIGHT_BELOW_CONTACT && heightAboveContact <= HEIGHT_ABOVE_CONTACT;
+	}
+}
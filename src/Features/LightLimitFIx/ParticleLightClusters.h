@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// Merges particle lights which fall into the same cell of a uniform world-space grid into one light.
+// Only depends on the standard library so it can be tested without the game.
+namespace ParticleLightClusters
+{
+	struct Float3
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f;
+	};
+
+	// Sums of every particle merged into a cell, averaged by Resolve
+	struct Cluster
+	{
+		Float3 color;
+		float radius = 0.0f;
+		Float3 position;
+		std::uint32_t count = 0;
+	};
+
+	struct Light
+	{
+		Float3 color;
+		float radius;
+		Float3 position;
+	};
+
+	// Key of the cell containing a_position, 21 bits per axis which covers any worldspace even at the smallest cell size
+	inline std::uint64_t GetKey(const Float3& a_position, float a_cellSize)
+	{
+		auto quantize = [a_cellSize](float a_value) {
+			return (std::uint64_t)((std::int64_t)std::floor(a_value / a_cellSize) & 0x1FFFFF);
+		};
+		return quantize(a_position.x) | (quantize(a_position.y) << 21) | (quantize(a_position.z) << 42);
+	}
+
+	// Colours add up, radius and position are averaged once every particle has been merged
+	inline void Merge(Cluster& a_cluster, const Float3& a_color, float a_radius, const Float3& a_position)
+	{
+		a_cluster.color.x += a_color.x;
+		a_cluster.color.y += a_color.y;
+		a_cluster.color.z += a_color.z;
+		a_cluster.radius += a_radius;
+		a_cluster.position.x += a_position.x;
+		a_cluster.position.y += a_position.y;
+		a_cluster.position.z += a_position.z;
+		a_cluster.count++;
+	}
+
+	inline Light Resolve(const Cluster& a_cluster)
+	{
+		float rcpCount = 1.0f / (float)a_cluster.count;
+		return {
+			a_cluster.color,
+			a_cluster.radius * rcpCount,
+			{ a_cluster.position.x * rcpCount, a_cluster.position.y * rcpCount, a_cluster.position.z * rcpCount }
+		};
+	}
+}
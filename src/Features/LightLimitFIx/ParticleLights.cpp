@@ -1,146 +1,390 @@
 #include "Features/LightLimitFix/ParticleLights.h"
+#include "Features/LightLimitFix/ParticleLightsCache.h"
 
+#include <execution>
 #include <numbers>
 
-void ParticleLights::GetConfigs()
-{
-	if (std::filesystem::exists("Data\\ParticleLights")) {
-		logger::info("[LLF] Loading particle lights configs");
+static constexpr const char* CONFIG_CACHE_PATH = "Data\\ShaderCache\\ParticleLights.bin";
 
-		auto configs = clib_util::distribution::get_configs("Data\\ParticleLights", "", ".ini");
+static std::vector<std::string> GetConfigPaths(const char* a_folder)
+{
+	if (!std::filesystem::exists(a_folder))
+		return {};
 
-		if (configs.empty()) {
-			logger::warn("[LLF] No .ini files were found within the Data\\ParticleLights folder, aborting...");
-			return;
-		}
+	logger::info("[LLF] Loading particle lights configs from {}", a_folder);
 
+	auto configs = clib_util::distribution::get_configs(a_folder, "", ".ini");
+	if (configs.empty())
+		logger::warn("[LLF] No .ini files were found within the {} folder", a_folder);
+	else
 		logger::info("[LLF] {} matching inis found", configs.size());
 
-		for (auto& path : configs) {
-			logger::info("[LLF] loading ini : {}", path);
-
-			CSimpleIniA ini;
-			ini.SetUnicode();
-			ini.SetMultiKey();
-
-			if (const auto rc = ini.LoadFile(path.c_str()); rc < 0) {
-				logger::error("\t\t[LLF] couldn't read INI");
-				continue;
-			}
-
-			Config data{};
-			particleLightConfigs.insert({ "default", data });
-
-			data.cull = ini.GetBoolValue("Light", "Cull", false);
-			data.colorMult.red = (float)ini.GetDoubleValue("Light", "ColorMultRed", 1.0);
-			data.colorMult.green = (float)ini.GetDoubleValue("Light", "ColorMultGreen", 1.0);
-			data.colorMult.blue = (float)ini.GetDoubleValue("Light", "ColorMultBlue", 1.0);
-			data.radiusMult = (float)ini.GetDoubleValue("Light", "RadiusMult", 1.0);
-			data.saturationMult = (float)ini.GetDoubleValue("Light", "SaturationMult", 1.0);
-			data.flicker = ini.GetBoolValue("Light", "Flicker", false);
-			data.flickerSpeed = (float)ini.GetDoubleValue("Light", "FlickerSpeed", 1.0);
-			data.flickerIntensity = (float)ini.GetDoubleValue("Light", "FlickerIntensity", 0.0);
-			data.flickerMovement = (float)ini.GetDoubleValue("Light", "FlickerMovement", 0.0) / std::numbers::pi_v<float>;
-
-			auto lastSeparatorPos = path.find_last_of("\\/");
-			if (lastSeparatorPos != std::string::npos) {
-				std::string filename = path.substr(lastSeparatorPos + 1);
-				if (filename.size() < 4) {
-					logger::error("[LLF] Path too short");
-					continue;
-				}
-
-				filename.erase(filename.length() - 4);  // Remove ".ini"
+	return configs;
+}
+
+// Lowercase file name without the ".ini" extension, empty if the path is invalid
+static std::string GetConfigName(const std::string& a_path)
+{
+	auto lastSeparatorPos = a_path.find_last_of("\\/");
+	if (lastSeparatorPos == std::string::npos) {
+		logger::error("[LLF] Path incomplete");
+		return {};
+	}
+
+	std::string filename = a_path.substr(lastSeparatorPos + 1);
+	if (filename.size() < 4) {
+		logger::error("[LLF] Path too short");
+		return {};
+	}
+
+	filename.erase(filename.length() - 4);  // Remove ".ini"
 #pragma warning(push)
 #pragma warning(disable: 4244)
-				std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
+	std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
 #pragma warning(pop)
+	return filename;
+}
 
-				logger::debug("[LLF] Inserting {}", filename);
+static bool LoadConfigIni(CSimpleIniA& a_ini, const std::string& a_path)
+{
+	logger::info("[LLF] loading ini : {}", a_path);
 
-				particleLightConfigs.insert({ filename, data });
-			} else {
-				logger::error("[LLF] Path incomplete");
-			}
-		}
+	a_ini.SetUnicode();
+	a_ini.SetMultiKey();
+
+	if (const auto rc = a_ini.LoadFile(a_path.c_str()); rc < 0) {
+		logger::error("\t\t[LLF] couldn't read INI");
+		return false;
 	}
+	return true;
+}
 
-	if (std::filesystem::exists("Data\\ParticleLights\\Gradients")) {
-		logger::info("[LLF] Loading particle lights gradients configs");
+static std::optional<ParticleLights::Config> ParseConfig(const CSimpleIniA& ini)
+{
+	ParticleLights::Config data{};
+	data.cull = ini.GetBoolValue("Light", "Cull", false);
+	data.colorMult.red = (float)ini.GetDoubleValue("Light", "ColorMultRed", 1.0);
+	data.colorMult.green = (float)ini.GetDoubleValue("Light", "ColorMultGreen", 1.0);
+	data.colorMult.blue = (float)ini.GetDoubleValue("Light", "ColorMultBlue", 1.0);
+	data.radiusMult = (float)ini.GetDoubleValue("Light", "RadiusMult", 1.0);
+	data.saturationMult = (float)ini.GetDoubleValue("Light", "SaturationMult", 1.0);
+	data.flicker = ini.GetBoolValue("Light", "Flicker", false);
+	data.flickerSpeed = (float)ini.GetDoubleValue("Light", "FlickerSpeed", 1.0);
+	data.flickerIntensity = (float)ini.GetDoubleValue("Light", "FlickerIntensity", 0.0);
+	data.flickerMovement = (float)ini.GetDoubleValue("Light", "FlickerMovement", 0.0) / std::numbers::pi_v<float>;
+	return data;
+}
 
-		auto configs = clib_util::distribution::get_configs("Data\\ParticleLights\\Gradients", "", ".ini");
+static std::optional<ParticleLights::GradientConfig> ParseGradientConfig(const CSimpleIniA& ini)
+{
+	ParticleLights::GradientConfig data{};
+	const char* value = nullptr;
+	constexpr std::string_view prefix1 = "0x";
+	constexpr std::string_view prefix2 = "#";
+	constexpr std::string_view cset = "0123456789ABCDEFabcdef";
+
+	value = ini.GetValue("Gradient", "Color");
+	if (value && strcmp(value, "") != 0) {
+		std::string_view str = value;
 
-		if (configs.empty()) {
-			logger::warn("[LLF] No .ini files were found within the Data\\ParticleLights\\Gradients folder, aborting...");
-			return;
+		if (str.starts_with(prefix1)) {
+			str.remove_prefix(prefix1.size());
 		}
 
-		logger::info("[LLF] {} matching inis found", configs.size());
+		if (str.starts_with(prefix2)) {
+			str.remove_prefix(prefix2.size());
+		}
+
+		bool matches = std::strspn(str.data(), cset.data()) == str.size();
+
+		if (matches) {
+			uint32_t color = std::stoi(str.data(), 0, 16);
+			data.color = color;
+		} else {
+			logger::error("[LLF] invalid color");
+			return std::nullopt;
+		}
+	} else {
+		logger::error("[LLF] missing color");
+		return std::nullopt;
+	}
+
+	return data;
+}
+
+// Parses every ini across threads, then merges in path order so the first file for a name wins as before
+template <class T, class F>
+static void ParseConfigs(const std::vector<std::string>& a_paths, const char* a_section, F a_parse, std::unordered_map<std::string, T>& a_configs, std::vector<std::pair<std::string, T>>& a_patterns)
+{
+	std::vector<ParticleLightsCache::ParsedConfig<T>> results(a_paths.size());
+	std::transform(std::execution::par, a_paths.begin(), a_paths.end(), results.begin(), [&](const std::string& a_path) {
+		ParticleLightsCache::ParsedConfig<T> result{ GetConfigName(a_path) };
+		CSimpleIniA ini;
+		if (result.name.empty() || !LoadConfigIni(ini, a_path))
+			return result;
+
+		result.data = a_parse(ini);
 
-		for (auto& path : configs) {
-			logger::info("[LLF] loading ini : {}", path);
-
-			CSimpleIniA ini;
-			ini.SetUnicode();
-			ini.SetMultiKey();
-
-			if (const auto rc = ini.LoadFile(path.c_str()); rc < 0) {
-				logger::error("\t\t[LLF] couldn't read INI");
-				continue;
-			}
-
-			GradientConfig data{};
-			const char* value = nullptr;
-			constexpr std::string_view prefix1 = "0x";
-			constexpr std::string_view prefix2 = "#";
-			constexpr std::string_view cset = "0123456789ABCDEFabcdef";
-
-			value = ini.GetValue("Gradient", "Color");
-			if (value && strcmp(value, "") != 0) {
-				std::string_view str = value;
-
-				if (str.starts_with(prefix1)) {
-					str.remove_prefix(prefix1.size());
-				}
-
-				if (str.starts_with(prefix2)) {
-					str.remove_prefix(prefix2.size());
-				}
-
-				bool matches = std::strspn(str.data(), cset.data()) == str.size();
-
-				if (matches) {
-					uint32_t color = std::stoi(str.data(), 0, 16);
-					data.color = color;
-				} else {
-					logger::error("[LLF] invalid color");
-					continue;
-				}
-			} else {
-				logger::error("[LLF] missing color");
-				continue;
-			}
-
-			auto lastSeparatorPos = path.find_last_of("\\/");
-			if (lastSeparatorPos != std::string::npos) {
-				std::string filename = path.substr(lastSeparatorPos + 1);
-				if (filename.size() < 4) {
-					logger::error("[LLF] Path too short");
-					continue;
-				}
-
-				filename.erase(filename.length() - 4);  // Remove ".ini"
+		CSimpleIniA::TNamesDepend values;
+		ini.GetAllValues(a_section, "Pattern", values);
+		values.sort(CSimpleIniA::Entry::LoadOrder());
+		for (const auto& value : values) {
+			std::string pattern = value.pItem;
 #pragma warning(push)
 #pragma warning(disable: 4244)
-				std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
+			std::transform(pattern.begin(), pattern.end(), pattern.begin(), ::tolower);
 #pragma warning(pop)
+			if (!pattern.empty())
+				result.patterns.push_back(std::move(pattern));
+		}
+		return result;
+	});
+
+	for (const auto& result : results) {
+		if (result.data)
+			logger::debug("[LLF] Inserting {} with {} patterns", result.name, result.patterns.size());
+	}
+
+	ParticleLightsCache::Merge(results, a_configs, a_patterns);
+}
+
+static void WriteConfig(ParticleLightsCache::Writer& a_writer, const ParticleLights::Config& a_config)
+{
+	a_writer.Write(a_config.cull);
+	a_writer.Write(a_config.colorMult.red);
+	a_writer.Write(a_config.colorMult.green);
+	a_writer.Write(a_config.colorMult.blue);
+	a_writer.Write(a_config.radiusMult);
+	a_writer.Write(a_config.saturationMult);
+	a_writer.Write(a_config.flicker);
+	a_writer.Write(a_config.flickerSpeed);
+	a_writer.Write(a_config.flickerIntensity);
+	a_writer.Write(a_config.flickerMovement);
+}
+
+static bool ReadConfig(ParticleLightsCache::Reader& a_reader, ParticleLights::Config& a_config)
+{
+	return a_reader.Read(a_config.cull) &&
+	       a_reader.Read(a_config.colorMult.red) &&
+	       a_reader.Read(a_config.colorMult.green) &&
+	       a_reader.Read(a_config.colorMult.blue) &&
+	       a_reader.Read(a_config.radiusMult) &&
+	       a_reader.Read(a_config.saturationMult) &&
+	       a_reader.Read(a_config.flicker) &&
+	       a_reader.Read(a_config.flickerSpeed) &&
+	       a_reader.Read(a_config.flickerIntensity) &&
+	       a_reader.Read(a_config.flickerMovement);
+}
+
+static void WriteGradientConfig(ParticleLightsCache::Writer& a_writer, const ParticleLights::GradientConfig& a_config)
+{
+	a_writer.Write(a_config.color.red);
+	a_writer.Write(a_config.color.green);
+	a_writer.Write(a_config.color.blue);
+}
+
+static bool ReadGradientConfig(ParticleLightsCache::Reader& a_reader, ParticleLights::GradientConfig& a_config)
+{
+	return a_reader.Read(a_config.color.red) && a_reader.Read(a_config.color.green) && a_reader.Read(a_config.color.blue);
+}
+
+bool ParticleLights::LoadConfigCache(std::uint64_t a_key)
+{
+	std::ifstream stream(CONFIG_CACHE_PATH, std::ios::binary);
+	if (!stream)
+		return false;
+
+	ParticleLightsCache::Reader reader(stream);
+	if (!ParticleLightsCache::ReadHeader(reader, a_key))
+		return false;
+
+	if (!ParticleLightsCache::ReadConfigs(reader, particleLightConfigs, ReadConfig) ||
+		!ParticleLightsCache::ReadConfigs(reader, particleLightGradientConfigs, ReadGradientConfig) ||
+		!ParticleLightsCache::ReadConfigs(reader, particleLightConfigPatterns, ReadConfig) ||
+		!ParticleLightsCache::ReadConfigs(reader, particleLightGradientConfigPatterns, ReadGradientConfig)) {
+		logger::warn("[LLF] Particle lights config cache is corrupt, reparsing");
+		particleLightConfigs.clear();
+		particleLightGradientConfigs.clear();
+		particleLightConfigPatterns.clear();
+		particleLightGradientConfigPatterns.clear();
+		return false;
+	}
+	return true;
+}
 
-				logger::debug("[LLF] Inserting {}", filename);
+void ParticleLights::SaveConfigCache(std::uint64_t a_key)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(std::filesystem::path(CONFIG_CACHE_PATH).parent_path(), ec);
+
+	std::ofstream stream(CONFIG_CACHE_PATH, std::ios::binary | std::ios::trunc);
+	if (!stream) {
+		logger::warn("[LLF] Couldn't write particle lights config cache");
+		return;
+	}
+
+	ParticleLightsCache::Writer writer(stream);
+	ParticleLightsCache::WriteHeader(writer, a_key);
+	ParticleLightsCache::WriteConfigs(writer, particleLightConfigs, WriteConfig);
+	ParticleLightsCache::WriteConfigs(writer, particleLightGradientConfigs, WriteGradientConfig);
+	ParticleLightsCache::WriteConfigs(writer, particleLightConfigPatterns, WriteConfig);
+	ParticleLightsCache::WriteConfigs(writer, particleLightGradientConfigPatterns, WriteGradientConfig);
+}
+
+void ParticleLights::GetConfigs()
+{
+	auto configPaths = GetConfigPaths("Data\\ParticleLights");
+	auto gradientConfigPaths = GetConfigPaths("Data\\ParticleLights\\Gradients");
+	if (configPaths.empty() && gradientConfigPaths.empty())
+		return;
+
+	auto cacheKey = ParticleLightsCache::GetKey(configPaths, gradientConfigPaths);
+	if (LoadConfigCache(cacheKey)) {
+		logger::info("[LLF] Loaded {} particle lights configs and {} gradients from cache", particleLightConfigs.size(), particleLightGradientConfigs.size());
+	} else {
+		ParseConfigs(configPaths, "Light", ParseConfig, particleLightConfigs, particleLightConfigPatterns);
+		ParseConfigs(gradientConfigPaths, "Gradient", ParseGradientConfig, particleLightGradientConfigs, particleLightGradientConfigPatterns);
+
+		SaveConfigCache(cacheKey);
+	}
+
+	BuildPatternMatchers();
+}
+
+void ParticleLights::BuildPatternMatchers()
+{
+	for (std::uint32_t i = 0; i < particleLightConfigPatterns.size(); i++)
+		configMatcher.Add(particleLightConfigPatterns[i].first, i);
+
+	for (std::uint32_t i = 0; i < particleLightGradientConfigPatterns.size(); i++)
+		gradientConfigMatcher.Add(particleLightGradientConfigPatterns[i].first, i);
+}
+
+void ParticleLights::PatternMatcher::Add(std::string_view a_pattern, std::uint32_t a_index)
+{
+	auto wildcard = a_pattern.find_first_of("*?");
+	if (wildcard != a_pattern.size() - 1 || a_pattern.back() != '*') {
+		globs.push_back({ std::string{ a_pattern }, a_index });
+		return;
+	}
+
+	std::uint32_t node = 0;
+	for (char c : a_pattern.substr(0, wildcard)) {
+		auto [it, inserted] = trie[node].children.try_emplace(c, (std::uint32_t)trie.size());
+		node = it->second;
+		if (inserted)
+			trie.emplace_back();
+	}
+
+	// The first config declaring a prefix wins
+	if (trie[node].index < 0)
+		trie[node].index = (std::int32_t)a_index;
+}
+
+std::int32_t ParticleLights::PatternMatcher::Find(std::string_view a_name) const
+{
+	std::uint32_t node = 0;
+	std::int32_t index = trie[node].index;
+	for (char c : a_name) {
+		auto it = trie[node].children.find(c);
+		if (it == trie[node].children.end())
+			break;
+		node = it->second;
+		if (trie[node].index >= 0)
+			index = trie[node].index;
+	}
 
-				particleLightGradientConfigs.insert({ filename, data });
-			} else {
-				logger::error("[LLF] Path incomplete");
-			}
+	if (index >= 0)
+		return index;
+
+	for (const auto& [pattern, globIndex] : globs) {
+		if (MatchGlob(pattern, a_name))
+			return (std::int32_t)globIndex;
+	}
+	return -1;
+}
+
+bool ParticleLights::PatternMatcher::MatchGlob(std::string_view a_pattern, std::string_view a_name)
+{
+	// Greedy matching which backtracks to the last '*'
+	size_t p = 0, n = 0;
+	size_t starPattern = std::string_view::npos, starName = 0;
+	while (n < a_name.size()) {
+		if (p < a_pattern.size() && (a_pattern[p] == '?' || a_pattern[p] == a_name[n])) {
+			p++;
+			n++;
+		} else if (p < a_pattern.size() && a_pattern[p] == '*') {
+			starPattern = p++;
+			starName = n;
+		} else if (starPattern != std::string_view::npos) {
+			p = starPattern + 1;
+			n = ++starName;
+		} else {
+			return false;
 		}
 	}
+
+	while (p < a_pattern.size() && a_pattern[p] == '*')
+		p++;
+	return p == a_pattern.size();
+}
+
+std::string ParticleLights::GetTextureStem(std::string_view a_texturePath)
+{
+	auto lastSeparatorPos = a_texturePath.find_last_of("\\/");
+	if (lastSeparatorPos == std::string_view::npos)
+		return {};
+
+	auto filename = a_texturePath.substr(lastSeparatorPos + 1);
+	if (filename.size() < 4)
+		return {};
+
+	filename.remove_suffix(4);  // Remove ".dds"
+
+	std::string textureName{ filename };
+#pragma warning(push)
+#pragma warning(disable: 4244)
+	std::transform(textureName.begin(), textureName.end(), textureName.begin(), ::tolower);
+#pragma warning(pop)
+	return textureName;
+}
+
+ParticleLights::Config* ParticleLights::GetConfig(const RE::BSFixedString& a_texturePath)
+{
+	std::lock_guard lock(lookupCacheMutex);
+
+	auto it = configLookupCache.find(a_texturePath.data());
+	if (it != configLookupCache.end())
+		return it->second.config;
+
+	Config* config = nullptr;
+	auto textureName = GetTextureStem(a_texturePath.c_str());
+	auto configIt = particleLightConfigs.find(textureName);
+	if (configIt != particleLightConfigs.end())
+		config = &configIt->second;
+	else if (auto index = configMatcher.Find(textureName); index >= 0)
+		config = &particleLightConfigPatterns[index].second;
+
+	configLookupCache.insert({ a_texturePath.data(), { a_texturePath, config } });
+	return config;
+}
+
+ParticleLights::GradientConfig* ParticleLights::GetGradientConfig(const RE::BSFixedString& a_texturePath)
+{
+	std::lock_guard lock(lookupCacheMutex);
+
+	auto it = gradientConfigLookupCache.find(a_texturePath.data());
+	if (it != gradientConfigLookupCache.end())
+		return it->second.config;
+
+	GradientConfig* config = nullptr;
+	auto textureName = GetTextureStem(a_texturePath.c_str());
+	auto configIt = particleLightGradientConfigs.find(textureName);
+	if (configIt != particleLightGradientConfigs.end())
+		config = &configIt->second;
+	else if (auto index = gradientConfigMatcher.Find(textureName); index >= 0)
+		config = &particleLightGradientConfigPatterns[index].second;
+
+	gradientConfigLookupCache.insert({ a_texturePath.data(), { a_texturePath, config } });
+	return config;
 }
@@ -35,5 +35,56 @@ public:
 	std::unordered_map<std::string, Config> particleLightConfigs;
 	std::unordered_map<std::string, GradientConfig> particleLightGradientConfigs;
 
+	// Declared with Pattern= in a config, used when no config matches the texture name exactly
+	std::vector<std::pair<std::string, Config>> particleLightConfigPatterns;
+	std::vector<std::pair<std::string, GradientConfig>> particleLightGradientConfigPatterns;
+
 	void GetConfigs();
+
+	Config* GetConfig(const RE::BSFixedString& a_texturePath);
+	GradientConfig* GetGradientConfig(const RE::BSFixedString& a_texturePath);
+
+private:
+	// '*' matches any run of characters and '?' a single character.
+	// Patterns with only a trailing '*' go in a trie and resolve to the longest prefix, other globs are tried in order.
+	class PatternMatcher
+	{
+	public:
+		void Add(std::string_view a_pattern, std::uint32_t a_index);
+		std::int32_t Find(std::string_view a_name) const;
+
+	private:
+		struct TrieNode
+		{
+			std::unordered_map<char, std::uint32_t> children;
+			std::int32_t index = -1;
+		};
+
+		std::vector<TrieNode> trie = std::vector<TrieNode>(1);
+		std::vector<std::pair<std::string, std::uint32_t>> globs;
+
+		static bool MatchGlob(std::string_view a_pattern, std::string_view a_name);
+	};
+
+	PatternMatcher configMatcher;
+	PatternMatcher gradientConfigMatcher;
+
+	void BuildPatternMatchers();
+
+	template <class T>
+	struct CachedLookup
+	{
+		RE::BSFixedString texturePath;  // Holds a reference so the interned string cannot be freed and its address reused
+		T* config;
+	};
+
+	// Keyed by the interned string address, misses are cached as nullptr. Lookups can come from several render threads.
+	std::mutex lookupCacheMutex;
+	eastl::hash_map<const void*, CachedLookup<Config>> configLookupCache;
+	eastl::hash_map<const void*, CachedLookup<GradientConfig>> gradientConfigLookupCache;
+
+	static std::string GetTextureStem(std::string_view a_texturePath);
+
+	bool LoadConfigCache(std::uint64_t a_key);
+	void SaveConfigCache(std::uint64_t a_key);
 };
\ No newline at end of file
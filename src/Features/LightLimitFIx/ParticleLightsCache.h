@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Binary cache of the parsed particle light configs, and the merge of parse results in path order.
+// Only depends on the standard library so it can be tested with fixture directories, ini parsing stays in ParticleLights.
+namespace ParticleLightsCache
+{
+	// Bump whenever the layout of the cache or of a serialised config changes
+	constexpr std::uint32_t VERSION = 3;
+
+	// FNV-1a over every path, size and modification time, so any added, removed or edited ini invalidates the cache
+	inline std::uint64_t GetKey(const std::vector<std::string>& a_configPaths, const std::vector<std::string>& a_gradientConfigPaths)
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		auto combine = [&hash](const void* a_data, std::size_t a_size) {
+			auto bytes = static_cast<const std::uint8_t*>(a_data);
+			for (std::size_t i = 0; i < a_size; i++) {
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+		};
+
+		for (const auto* paths : { &a_configPaths, &a_gradientConfigPaths }) {
+			std::uint64_t count = paths->size();
+			combine(&count, sizeof(count));
+			for (const auto& path : *paths) {
+				std::error_code ec;
+				std::int64_t writeTime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+				std::uint64_t size = std::filesystem::file_size(path, ec);
+				combine(path.data(), path.size() + 1);
+				combine(&writeTime, sizeof(writeTime));
+				combine(&size, sizeof(size));
+			}
+		}
+		return hash;
+	}
+
+	// Writes values field by field, so struct padding never reaches the file
+	class Writer
+	{
+	public:
+		explicit Writer(std::ostream& a_stream) :
+			stream(a_stream) {}
+
+		template <class T>
+		requires std::is_arithmetic_v<T>
+		void Write(T a_value)
+		{
+			stream.write(reinterpret_cast<const char*>(&a_value), sizeof(T));
+		}
+
+		void Write(bool a_value)
+		{
+			Write((std::uint8_t)(a_value ? 1 : 0));
+		}
+
+		void Write(const std::string& a_value)
+		{
+			Write((std::uint32_t)a_value.size());
+			stream.write(a_value.data(), (std::streamsize)a_value.size());
+		}
+
+	private:
+		std::ostream& stream;
+	};
+
+	// Reads values written by Writer, every call returns false once the stream is exhausted or corrupt
+	class Reader
+	{
+	public:
+		explicit Reader(std::istream& a_stream) :
+			stream(a_stream) {}
+
+		template <class T>
+		requires std::is_arithmetic_v<T>
+		bool Read(T& a_value)
+		{
+			return (bool)stream.read(reinterpret_cast<char*>(&a_value), sizeof(T));
+		}
+
+		bool Read(bool& a_value)
+		{
+			std::uint8_t value = 0;
+			if (!Read(value) || value > 1)
+				return false;
+			a_value = value != 0;
+			return true;
+		}
+
+		bool Read(std::string& a_value)
+		{
+			std::uint32_t length = 0;
+			if (!Read(length))
+				return false;
+			a_value.assign(length, '\0');
+			return (bool)stream.read(a_value.data(), length);
+		}
+
+	private:
+		std::istream& stream;
+	};
+
+	inline void WriteHeader(Writer& a_writer, std::uint64_t a_key)
+	{
+		a_writer.Write(VERSION);
+		a_writer.Write(a_key);
+	}
+
+	// Whether the cache was written by this version for the same set of inis
+	inline bool ReadHeader(Reader& a_reader, std::uint64_t a_key)
+	{
+		std::uint32_t version = 0;
+		std::uint64_t key = 0;
+		return a_reader.Read(version) && version == VERSION && a_reader.Read(key) && key == a_key;
+	}
+
+	// Writes a map or list of (name, config) pairs, a_write serialises one config
+	template <class C, class F>
+	void WriteConfigs(Writer& a_writer, const C& a_configs, F a_write)
+	{
+		a_writer.Write((std::uint32_t)a_configs.size());
+		for (const auto& [name, data] : a_configs) {
+			a_writer.Write(name);
+			a_write(a_writer, data);
+		}
+	}
+
+	template <class C, class F>
+	bool ReadConfigs(Reader& a_reader, C& a_configs, F a_read)
+	{
+		using T = std::remove_cvref_t<decltype(a_configs.begin()->second)>;
+		std::uint32_t count = 0;
+		if (!a_reader.Read(count))
+			return false;
+
+		a_configs.reserve(count);
+		for (std::uint32_t i = 0; i < count; i++) {
+			std::string name;
+			T data{};
+			if (!a_reader.Read(name) || !a_read(a_reader, data))
+				return false;
+			a_configs.insert(a_configs.end(), { std::move(name), data });
+		}
+		return true;
+	}
+
+	template <class T>
+	struct ParsedConfig
+	{
+		std::string name;
+		std::optional<T> data;
+		std::vector<std::string> patterns;
+	};
+
+	// Merges parse results in path order, so the first file for a name wins regardless of which thread parsed it
+	template <class T>
+	void Merge(std::vector<ParsedConfig<T>>& a_results, std::unordered_map<std::string, T>& a_configs, std::vector<std::pair<std::string, T>>& a_patterns)
+	{
+		for (auto& result : a_results) {
+			if (!result.data)
+				continue;
+
+			for (auto& pattern : result.patterns)
+				a_patterns.push_back({ std::move(pattern), *result.data });
+
+			a_configs.insert({ std::move(result.name), *result.data });
+		}
+	}
+}
@@ -9,9 +9,16 @@ static constexpr uint CLUSTER_SIZE_X = 16;
 static constexpr uint CLUSTER_SIZE_Y = 16;
 static constexpr uint CLUSTER_SIZE_Z = 16;
 constexpr uint CLUSTER_MAX_LIGHTS = 128;
+constexpr uint STRICT_LIGHT_DATA_RING_SIZE = 1024;
 
 constexpr std::uint32_t CLUSTER_COUNT = CLUSTER_SIZE_X * CLUSTER_SIZE_Y * CLUSTER_SIZE_Z;
 
+constexpr float PARTICLE_LIGHTS_DETECTION_CELL_SIZE = 512.0f;
+
+constexpr uint FLICKER_NOISE_PERIOD = 256;  // siv::PerlinNoise repeats every 256 units
+constexpr uint FLICKER_NOISE_SAMPLES_PER_UNIT = 16;
+constexpr uint FLICKER_NOISE_TABLE_SIZE = FLICKER_NOISE_PERIOD * FLICKER_NOISE_SAMPLES_PER_UNIT;
+
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
 	LightLimitFix::Settings,
 	EnableContactShadows,
@@ -22,7 +29,8 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
 	ParticleLightsBrightness,
 	ParticleLightsSaturation,
 	EnableParticleLightsOptimization,
-	ParticleLightsOptimisationClusterRadius)
+	ParticleLightsOptimisationClusterRadius,
+	ParticleLightsBudget)
 
 void LightLimitFix::DrawSettings()
 {
@@ -58,7 +66,7 @@ void LightLimitFix::DrawSettings()
 		if (ImGui::IsItemHovered()) {
 			ImGui::BeginTooltip();
 			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
-			ImGui::Text("Merges vertices which are close enough to each other to significantly improve performance.");
+			ImGui::Text("Merges particles which fall into the same grid cell to significantly improve performance.");
 			ImGui::PopTextWrapPos();
 			ImGui::EndTooltip();
 		}
@@ -66,7 +74,15 @@ void LightLimitFix::DrawSettings()
 		if (ImGui::IsItemHovered()) {
 			ImGui::BeginTooltip();
 			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
-			ImGui::Text("Radius to use for clustering lights.");
+			ImGui::Text("Size of the grid cells used for clustering lights.");
+			ImGui::PopTextWrapPos();
+			ImGui::EndTooltip();
+		}
+		ImGui::SliderInt("Light Budget", (int*)&settings.ParticleLightsBudget, 0, 4096);
+		if (ImGui::IsItemHovered()) {
+			ImGui::BeginTooltip();
+			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+			ImGui::Text("Maximum number of particle lights per frame. The most visible lights are kept. 0 means unlimited.");
 			ImGui::PopTextWrapPos();
 			ImGui::EndTooltip();
 		}
@@ -153,7 +169,34 @@ void LightLimitFix::DrawSettings()
 
 	if (ImGui::TreeNodeEx("Statistics", ImGuiTreeNodeFlags_DefaultOpen)) {
 		ImGui::Text(std::format("Clustered Light Count : {}", lightCount).c_str());
-		ImGui::Text(std::format("Particle Lights Detection Count : {}", particleLightsDetectionHits).c_str());
+		ImGui::Text(std::format("Particle Lights Detection Count : {}", particleLightsDetectionHits.load()).c_str());
+		ImGui::Text(std::format("Particle Lights Culled by Budget : {}", particleLightsBudgetCulled).c_str());
+
+		collectStatistics = true;
+
+		ImGui::Spacing();
+		ImGui::Text(std::format("Max Lights per Cluster : {}", statistics.maxLightsPerCluster).c_str());
+		ImGui::Text(std::format("Clusters at Light Limit : {}", statistics.saturatedClusters).c_str());
+
+		float occupancy[LIGHT_GRID_HISTOGRAM_BUCKETS];
+		for (uint i = 0; i < LIGHT_GRID_HISTOGRAM_BUCKETS; i++)
+			occupancy[i] = (float)statistics.occupancy[i];
+		ImGui::PlotHistogram("Cluster Occupancy", occupancy, LIGHT_GRID_HISTOGRAM_BUCKETS, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 80));
+		if (ImGui::IsItemHovered()) {
+			ImGui::BeginTooltip();
+			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+			ImGui::Text(
+				"Number of clusters by light count, read back a few frames late. "
+				"The first bar is empty clusters, each following bar covers 16 lights, and the last bar is clusters at the light limit. ");
+			ImGui::PopTextWrapPos();
+			ImGui::EndTooltip();
+		}
+
+		ImGui::Spacing();
+		ImGui::Text(std::format("Point Lights : {:.3f} ms", statistics.pointLightsTime).c_str());
+		ImGui::Text(std::format("Particle Lights : {:.3f} ms", statistics.particleLightsTime).c_str());
+		ImGui::Text(std::format("Light Upload : {:.3f} ms", statistics.uploadTime).c_str());
+		ImGui::Text(std::format("Clustering : {:.3f} ms", statistics.clusteringTime).c_str());
 
 		ImGui::TreePop();
 	}
@@ -180,13 +223,19 @@ void LightLimitFix::SetupResources()
 	}
 
 	{
+		auto device = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().forwarder;
+
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+		strictLightDataRing = SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) && options.MapNoOverwriteOnDynamicBufferSRV;
+		uint strictLightDataCount = strictLightDataRing ? STRICT_LIGHT_DATA_RING_SIZE : 1;
+
 		D3D11_BUFFER_DESC sbDesc{};
 		sbDesc.Usage = D3D11_USAGE_DYNAMIC;
 		sbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 		sbDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 		sbDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
 		sbDesc.StructureByteStride = sizeof(StrictLightData);
-		sbDesc.ByteWidth = sizeof(StrictLightData);
+		sbDesc.ByteWidth = sizeof(StrictLightData) * strictLightDataCount;
 		strictLightData = std::make_unique<Buffer>(sbDesc);
 
 		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
@@ -195,6 +244,16 @@ void LightLimitFix::SetupResources()
 		srvDesc.Buffer.FirstElement = 0;
 		srvDesc.Buffer.NumElements = 1;
 		strictLightData->CreateSRV(srvDesc);
+
+		// One single-element view per ring slot, so the shader always reads element 0
+		strictLightDataViews.resize(strictLightDataCount);
+		for (uint i = 0; i < strictLightDataCount; i++) {
+			srvDesc.Buffer.FirstElement = i;
+			DX::ThrowIfFailed(device->CreateShaderResourceView(strictLightData->resource.get(), &srvDesc, strictLightDataViews[i].put()));
+		}
+
+		strictLightDataRingIndex = 0;
+		strictLightDataValid = false;
 	}
 	{
 		clusterBuildingCS = (ID3D11ComputeShader*)Util::CompileShader(L"Data\\Shaders\\LightLimitFix\\ClusterBuildingCS.hlsl", {}, "cs_5_0");
@@ -221,7 +280,8 @@ void LightLimitFix::SetupResources()
 		uavDesc.Buffer.FirstElement = 0;
 		uavDesc.Buffer.Flags = 0;
 
-		std::uint32_t numElements = CLUSTER_COUNT;
+		// One grid per eye so VR culls each eye against its own frustum
+		std::uint32_t numElements = CLUSTER_COUNT * eyeCount;
 
 		sbDesc.StructureByteStride = sizeof(ClusterAABB);
 		sbDesc.ByteWidth = sizeof(ClusterAABB) * numElements;
@@ -240,7 +300,7 @@ void LightLimitFix::SetupResources()
 		uavDesc.Buffer.NumElements = numElements;
 		lightCounter->CreateUAV(uavDesc);
 
-		numElements = CLUSTER_COUNT * CLUSTER_MAX_LIGHTS;
+		numElements = CLUSTER_COUNT * CLUSTER_MAX_LIGHTS * eyeCount;
 		sbDesc.StructureByteStride = sizeof(uint32_t);
 		sbDesc.ByteWidth = sizeof(uint32_t) * numElements;
 		lightList = eastl::make_unique<Buffer>(sbDesc);
@@ -249,7 +309,7 @@ void LightLimitFix::SetupResources()
 		uavDesc.Buffer.NumElements = numElements;
 		lightList->CreateUAV(uavDesc);
 
-		numElements = CLUSTER_COUNT;
+		numElements = CLUSTER_COUNT * eyeCount;
 		sbDesc.StructureByteStride = sizeof(LightGrid);
 		sbDesc.ByteWidth = sizeof(LightGrid) * numElements;
 		lightGrid = eastl::make_unique<Buffer>(sbDesc);
@@ -257,22 +317,33 @@ void LightLimitFix::SetupResources()
 		lightGrid->CreateSRV(srvDesc);
 		uavDesc.Buffer.NumElements = numElements;
 		lightGrid->CreateUAV(uavDesc);
+
+		for (auto& cache : clusterGridCache)
+			cache.valid = false;
+
+		for (uint i = 0; i < LIGHT_GRID_READBACK_LATENCY; i++) {
+			lightGridReadback[i] = nullptr;
+			lightGridReadbackPending[i] = false;
+		}
 	}
 }
 
 void LightLimitFix::Reset()
 {
 	rendered = false;
-	for (auto& particleLight : particleLights) {
-		if (const auto particleSystem = netimmerse_cast<RE::NiParticleSystem*>(particleLight.first)) {
-			if (auto particleData = particleSystem->GetParticleRuntimeData().particleData.get()) {
-				particleData->DecRefCount();
-			}
-		}
-		particleLight.first->DecRefCount();
+	std::lock_guard lock(queuedParticleLightsMutex);
+	// Only release geometry that was not queued again this frame, persistent geometry keeps its reference
+	for (auto& [geometry, info] : particleLights) {
+		auto queued = queuedParticleLights.find(geometry);
+		bool persistent = queued != queuedParticleLights.end();
+		if (info.particleData && (!persistent || queued->second.particleData != info.particleData))
+			info.particleData->DecRefCount();
+		if (!persistent)
+			geometry->DecRefCount();
 	}
 	particleLights.clear();
 	std::swap(particleLights, queuedParticleLights);
+	PruneVertexColorCache();
 }
 
 void LightLimitFix::Load(json& o_json)
@@ -318,14 +389,47 @@ void LightLimitFix::BSLightingShader_SetupGeometry_GeometrySetupConstantPointLig
 	}
 }
 
+bool LightLimitFix::StrictLightDataChanged() const
+{
+	if (!strictLightDataValid || strictLightDataTemp.NumLights != strictLightDataUploaded.NumLights)
+		return true;
+
+	// Only the active lights are read by the shader
+	auto numLights = std::min(strictLightDataTemp.NumLights, 15u);
+	return memcmp(strictLightDataTemp.PointLightPosition, strictLightDataUploaded.PointLightPosition, sizeof(float3) * numLights) ||
+	       memcmp(strictLightDataTemp.PointLightRadius, strictLightDataUploaded.PointLightRadius, sizeof(float) * numLights) ||
+	       memcmp(strictLightDataTemp.PointLightColor, strictLightDataUploaded.PointLightColor, sizeof(float3) * numLights);
+}
+
 void LightLimitFix::BSLightingShader_SetupGeometry_After(RE::BSRenderPass*)
 {
+	if (!StrictLightDataChanged())
+		return;
+
 	auto context = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context;
-	D3D11_MAPPED_SUBRESOURCE mapped;
-	DX::ThrowIfFailed(context->Map(strictLightData->resource.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
 	size_t bytes = sizeof(StrictLightData);
-	memcpy_s(mapped.pData, bytes, &strictLightDataTemp, bytes);
-	context->Unmap(strictLightData->resource.get(), 0);
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	if (strictLightDataRing) {
+		// Append to the ring without stalling on draws still reading earlier slots, and only discard when it wraps
+		auto mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+		if (++strictLightDataRingIndex >= STRICT_LIGHT_DATA_RING_SIZE) {
+			strictLightDataRingIndex = 0;
+			mapType = D3D11_MAP_WRITE_DISCARD;
+		}
+		DX::ThrowIfFailed(context->Map(strictLightData->resource.get(), 0, mapType, 0, &mapped));
+		memcpy_s((std::uint8_t*)mapped.pData + bytes * strictLightDataRingIndex, bytes, &strictLightDataTemp, bytes);
+		context->Unmap(strictLightData->resource.get(), 0);
+
+		ID3D11ShaderResourceView* views[1]{ strictLightDataViews[strictLightDataRingIndex].get() };
+		context->PSSetShaderResources(37, ARRAYSIZE(views), views);
+	} else {
+		DX::ThrowIfFailed(context->Map(strictLightData->resource.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+		memcpy_s(mapped.pData, bytes, &strictLightDataTemp, bytes);
+		context->Unmap(strictLightData->resource.get(), 0);
+	}
+
+	strictLightDataUploaded = strictLightDataTemp;
+	strictLightDataValid = true;
 }
 
 void LightLimitFix::SetLightPosition(LightLimitFix::LightData& a_light, RE::NiPoint3& a_initialPosition)
@@ -359,19 +463,56 @@ float LightLimitFix::CalculateLuminance(CachedParticleLight& light, RE::NiPoint3
 	return light.grey * intensityMultiplier;
 }
 
+std::uint64_t LightLimitFix::GetDetectionCellKey(std::int32_t a_x, std::int32_t a_y)
+{
+	return ((std::uint64_t)(std::uint32_t)a_x << 32) | (std::uint64_t)(std::uint32_t)a_y;
+}
+
+void LightLimitFix::BuildParticleLightsDetectionGrid()
+{
+	// Flat 2D grid sorted by cell, each light is listed in every cell its radius overlaps
+	cachedParticleLightCells.clear();
+	for (uint32_t i = 0; i < (uint32_t)cachedParticleLights.size(); i++) {
+		auto& light = cachedParticleLights[i];
+		auto minX = (std::int32_t)std::floor((light.position.x - light.radius) / PARTICLE_LIGHTS_DETECTION_CELL_SIZE);
+		auto maxX = (std::int32_t)std::floor((light.position.x + light.radius) / PARTICLE_LIGHTS_DETECTION_CELL_SIZE);
+		auto minY = (std::int32_t)std::floor((light.position.y - light.radius) / PARTICLE_LIGHTS_DETECTION_CELL_SIZE);
+		auto maxY = (std::int32_t)std::floor((light.position.y + light.radius) / PARTICLE_LIGHTS_DETECTION_CELL_SIZE);
+		for (auto y = minY; y <= maxY; y++) {
+			for (auto x = minX; x <= maxX; x++) {
+				cachedParticleLightCells.push_back({ GetDetectionCellKey(x, y), i });
+			}
+		}
+	}
+
+	std::sort(cachedParticleLightCells.begin(), cachedParticleLightCells.end(), [](const CachedParticleLightCell& a, const CachedParticleLightCell& b) {
+		return a.key < b.key;
+	});
+}
+
 void LightLimitFix::AddParticleLightLuminance(RE::NiPoint3& targetPosition, int& numHits, float& lightLevel)
 {
-	std::lock_guard<std::shared_mutex> lk{ cachedParticleLightsMutex };
-	particleLightsDetectionHits = 0;
+	uint32_t hits = 0;
 	if (settings.EnableParticleLightsDetection) {
-		for (auto& light : cachedParticleLights) {
-			auto luminance = CalculateLuminance(light, targetPosition);
+		std::shared_lock<std::shared_mutex> lk{ cachedParticleLightsMutex };
+
+		auto key = GetDetectionCellKey(
+			(std::int32_t)std::floor(targetPosition.x / PARTICLE_LIGHTS_DETECTION_CELL_SIZE),
+			(std::int32_t)std::floor(targetPosition.y / PARTICLE_LIGHTS_DETECTION_CELL_SIZE));
+
+		auto first = std::lower_bound(cachedParticleLightCells.begin(), cachedParticleLightCells.end(), key, [](const CachedParticleLightCell& a_cell, std::uint64_t a_key) {
+			return a_cell.key < a_key;
+		});
+
+		for (auto it = first; it != cachedParticleLightCells.end() && it->key == key; ++it) {
+			auto luminance = CalculateLuminance(cachedParticleLights[it->index], targetPosition);
 			lightLevel += luminance;
 			if (luminance > 0.0)
-				particleLightsDetectionHits++;
+				hits++;
 		}
 	}
-	numHits += particleLightsDetectionHits;
+	particleLightsDetectionHits = hits;
+	numHits += hits;
 }
 
 void LightLimitFix::Bind()
@@ -454,7 +595,7 @@ void LightLimitFix::Bind()
 
 	{
 		ID3D11ShaderResourceView* views[1]{};
-		views[0] = strictLightData->srv.get();
+		views[0] = strictLightDataViews[strictLightDataRingIndex].get();
 		context->PSSetShaderResources(37, ARRAYSIZE(views), views);
 	}
 }
@@ -469,10 +610,78 @@ bool LightLimitFix::IsGlobalLight(RE::BSLight* a_light)
 	return !(a_light->portalStrict || !a_light->portalGraph);
 }
 
-struct VertexColor
+static constexpr uint VERTEX_COLOR_CACHE_PRUNE_INTERVAL = 1024;
+
+// Returns the colour of the first vertex with the highest alpha
+static RE::NiColorA GetMaxAlphaVertexColor(const std::uint8_t* a_colors, uint32_t a_vertexSize, uint32_t a_vertexCount)
 {
-	std::uint8_t data[4];
-};
+	// Colours are packed RGBA8, a fully opaque vertex cannot be beaten so the scan stops there
+	const std::uint8_t* maxColor = nullptr;
+	std::uint8_t maxAlpha = 0;
+	for (uint32_t v = 0; v < a_vertexCount; v++) {
+		const std::uint8_t* color = a_colors + a_vertexSize * v;
+		if (color[3] > maxAlpha) {
+			maxAlpha = color[3];
+			maxColor = color;
+			if (maxAlpha == 255)
+				break;
+		}
+	}
+
+	if (!maxColor)
+		return {};
+	return { (float)maxColor[0] / 255.0f, (float)maxColor[1] / 255.0f, (float)maxColor[2] / 255.0f, (float)maxColor[3] / 255.0f };
+}
+
+RE::NiColorA LightLimitFix::GetCachedVertexColor(const void* a_rendererData, const std::uint8_t* a_colors, uint32_t a_vertexSize, uint32_t a_vertexCount)
+{
+	auto frameCount = RE::BSGraphics::State::GetSingleton()->uiFrameCount;
+
+	std::lock_guard lock(vertexColorCacheMutex);
+
+	// Renderer data can be freed and its address reused by new geometry, which also brings new vertex data
+	auto it = vertexColorCache.find(a_rendererData);
+	if (it != vertexColorCache.end() && it->second.colors == a_colors && it->second.vertexSize == a_vertexSize && it->second.vertexCount == a_vertexCount) {
+		it->second.lastUsedFrame = frameCount;
+		return it->second.color;
+	}
+
+	auto color = GetMaxAlphaVertexColor(a_colors, a_vertexSize, a_vertexCount);
+	vertexColorCache[a_rendererData] = { a_colors, a_vertexSize, a_vertexCount, frameCount, color };
+	return color;
+}
+
+void LightLimitFix::PruneVertexColorCache()
+{
+	// Entries are validated on use, pruning only bounds the memory held by geometry which is gone
+	auto frameCount = RE::BSGraphics::State::GetSingleton()->uiFrameCount;
+	if (frameCount % VERTEX_COLOR_CACHE_PRUNE_INTERVAL != 0)
+		return;
+
+	std::lock_guard lock(vertexColorCacheMutex);
+	for (auto it = vertexColorCache.begin(); it != vertexColorCache.end();) {
+		if (frameCount - it->second.lastUsedFrame > VERTEX_COLOR_CACHE_PRUNE_INTERVAL)
+			it = vertexColorCache.erase(it);
+		else
+			++it;
+	}
+}
+
+void LightLimitFix::AcquireParticleLight(RE::BSGeometry* a_geometry, ParticleLightInfo& a_info)
+{
+	auto previous = particleLights.find(a_geometry);
+	bool held = previous != particleLights.end();
+	if (!held)
+		a_geometry->IncRefCount();
+
+	RE::NiParticlesData* particleData = nullptr;
+	if (const auto particleSystem = netimmerse_cast<RE::NiParticleSystem*>(a_geometry))
+		particleData = particleSystem->GetParticleRuntimeData().particleData.get();
+
+	if (particleData && (!held || previous->second.particleData != particleData))
+		particleData->IncRefCount();
+	a_info.particleData = particleData;
+}
 
 bool LightLimitFix::CheckParticleLights(RE::BSRenderPass* a_pass, uint32_t)
 {
@@ -482,67 +691,17 @@ bool LightLimitFix::CheckParticleLights(RE::BSRenderPass* a_pass, uint32_t)
 			if (!shaderProperty->lightData) {
 				if (auto material = shaderProperty->material) {
 					if (!material->sourceTexturePath.empty()) {
-						std::string textureName = material->sourceTexturePath.c_str();
-
-						{
-							if (textureName.size() < 1)
-								return false;
-
-							auto lastSeparatorPos = textureName.find_last_of("\\/");
-							if (lastSeparatorPos == std::string::npos)
-								return false;
-
-							textureName = textureName.substr(lastSeparatorPos + 1);
-							if (textureName.size() < 4)
-								return false;
+						auto particleLightsConfigs = ParticleLights::GetSingleton();
 
-							textureName.erase(textureName.length() - 4);  // Remove ".dds"
-#pragma warning(push)
-#pragma warning(disable: 4244)
-							std::transform(textureName.begin(), textureName.end(), textureName.begin(), ::tolower);
-#pragma warning(pop)
-						}
-
-						auto& configs = ParticleLights::GetSingleton()->particleLightConfigs;
-						auto it = configs.find(textureName);
-						if (it == configs.end())
+						ParticleLights::Config* config = particleLightsConfigs->GetConfig(material->sourceTexturePath);
+						if (!config)
 							return false;
 
-						ParticleLights::Config* config = &it->second;
 						ParticleLights::GradientConfig* gradientConfig = nullptr;
 						if (!material->greyscaleTexturePath.empty()) {
-							textureName = material->greyscaleTexturePath.c_str();
-							{
-								if (textureName.size() < 1)
-									return false;
-
-								auto lastSeparatorPos = textureName.find_last_of("\\/");
-								if (lastSeparatorPos == std::string::npos)
-									return false;
-
-								textureName = textureName.substr(lastSeparatorPos + 1);
-								if (textureName.size() < 4)
-									return false;
-
-								textureName.erase(textureName.length() - 4);  // Remove ".dds"
-#pragma warning(push)
-#pragma warning(disable: 4244)
-								std::transform(textureName.begin(), textureName.end(), textureName.begin(), ::tolower);
-#pragma warning(pop)
-							}
-
-							auto& gradientConfigs = ParticleLights::GetSingleton()->particleLightGradientConfigs;
-							auto itGradient = gradientConfigs.find(textureName);
-							if (itGradient == gradientConfigs.end())
+							gradientConfig = particleLightsConfigs->GetGradientConfig(material->greyscaleTexturePath);
+							if (!gradientConfig)
 								return false;
-							gradientConfig = &itGradient->second;
-						}
-
-						a_pass->geometry->IncRefCount();
-						if (const auto particleSystem = netimmerse_cast<RE::NiParticleSystem*>(a_pass->geometry)) {
-							if (auto particleData = particleSystem->GetParticleRuntimeData().particleData.get()) {
-								particleData->IncRefCount();
-							}
 						}
 
 						RE::NiColorA color;
@@ -562,14 +721,7 @@ bool LightLimitFix::CheckParticleLights(RE::BSRenderPass* a_pass, uint32_t)
 								if (auto triShape = a_pass->geometry->AsTriShape()) {
 									uint32_t vertexSize = rendererData->vertexDesc.GetSize();
 									uint32_t offset = rendererData->vertexDesc.GetAttributeOffset(RE::BSGraphics::Vertex::Attribute::VA_COLOR);
-									RE::NiColorA vertexColor{};
-									for (int v = 0; v < triShape->GetTrishapeRuntimeData().vertexCount; v++) {
-										if (VertexColor* vertex = reinterpret_cast<VertexColor*>(&rendererData->rawVertexData[vertexSize * v + offset])) {
-											RE::NiColorA niColor{ (float)vertex->data[0] / 255.0f, (float)vertex->data[1] / 255.0f, (float)vertex->data[2] / 255.0f, (float)vertex->data[3] / 255.0f };
-											if (niColor.alpha > vertexColor.alpha)
-												vertexColor = niColor;
-										}
-									}
+									RE::NiColorA vertexColor = GetCachedVertexColor(rendererData, &rendererData->rawVertexData[offset], vertexSize, triShape->GetTrishapeRuntimeData().vertexCount);
 									color.red *= vertexColor.red;
 									color.green *= vertexColor.green;
 									color.blue *= vertexColor.blue;
@@ -591,7 +743,12 @@ bool LightLimitFix::CheckParticleLights(RE::BSRenderPass* a_pass, uint32_t)
 							color.blue *= config->colorMult.blue;
 						}
 
-						queuedParticleLights.insert({ a_pass->geometry, { color, *config } });
+						{
+							std::lock_guard lock(queuedParticleLightsMutex);
+							auto [it, inserted] = queuedParticleLights.insert({ a_pass->geometry, { color, *config } });
+							if (inserted)
+								AcquireParticleLight(a_pass->geometry, it->second);
+						}
 
 						return settings.EnableParticleLightsCulling && config->cull;
 					}
@@ -644,6 +801,48 @@ float LightLimitFix::CalculateLightDistance(float3 a_lightPosition, float a_radi
 	return (a_lightPosition.x * a_lightPosition.x) + (a_lightPosition.y * a_lightPosition.y) + (a_lightPosition.z * a_lightPosition.z) - (a_radius * a_radius);
 }
 
+static const std::array<float, FLICKER_NOISE_TABLE_SIZE>& GetFlickerNoiseTable()
+{
+	// Built once and shared by every flickering light, lights only differ by their phase
+	static const auto table = [] {
+		std::array<float, FLICKER_NOISE_TABLE_SIZE> noise{};
+		siv::PerlinNoise perlin{};
+		for (uint i = 0; i < FLICKER_NOISE_TABLE_SIZE; i++)
+			noise[i] = (float)perlin.noise1D((double)i / FLICKER_NOISE_SAMPLES_PER_UNIT);
+		return noise;
+	}();
+	return table;
+}
+
+static float4 GetFlickerPhase(RE::BSGeometry* a_geometry)
+{
+	// Split the pointer hash into four independent offsets within the noise period
+	auto seed = (std::uint64_t)std::hash<void*>{}(a_geometry);
+	float4 phase;
+	phase.x = (float)((seed >> 0) & 0xFFFF) * (FLICKER_NOISE_PERIOD / 65536.0f);
+	phase.y = (float)((seed >> 16) & 0xFFFF) * (FLICKER_NOISE_PERIOD / 65536.0f);
+	phase.z = (float)((seed >> 32) & 0xFFFF) * (FLICKER_NOISE_PERIOD / 65536.0f);
+	phase.w = (float)((seed >> 48) & 0xFFFF) * (FLICKER_NOISE_PERIOD / 65536.0f);
+	return phase;
+}
+
+static float4 SampleFlickerNoise(double a_time, const float4& a_phase)
+{
+	auto& table = GetFlickerNoiseTable();
+
+	const float phases[4] = { a_phase.x, a_phase.y, a_phase.z, a_phase.w };
+	float noise[4];
+	for (int i = 0; i < 4; i++) {
+		double position = std::fmod((a_time + phases[i]) * FLICKER_NOISE_SAMPLES_PER_UNIT, (double)FLICKER_NOISE_TABLE_SIZE);
+		if (position < 0.0)
+			position += FLICKER_NOISE_TABLE_SIZE;
+		uint index = (uint)position;
+		float weight = (float)(position - index);
+		noise[i] = std::lerp(table[index % FLICKER_NOISE_TABLE_SIZE], table[(index + 1) % FLICKER_NOISE_TABLE_SIZE], weight);
+	}
+	return { noise[0], noise[1], noise[2], noise[3] };
+}
+
 bool LightLimitFix::AddCachedParticleLights(eastl::vector<LightData>& lightsData, LightLimitFix::LightData& light, ParticleLights::Config* a_config, RE::BSGeometry* a_geometry, double a_timer)
 {
 	static float& lightFadeStart = (*(float*)RELOCATION_ID(527668, 414582).address());
@@ -678,24 +877,18 @@ bool LightLimitFix::AddCachedParticleLights(eastl::vector<LightData>& lightsData
 
 	if ((light.color.x + light.color.y + light.color.z) > 1e-4 && light.radius > 1e-4) {
 		if (a_geometry && a_config && a_config->flicker) {
-			auto seed = (std::uint32_t)std::hash<void*>{}(a_geometry);
-
-			siv::PerlinNoise perlin1{ seed };
-			siv::PerlinNoise perlin2{ seed + 1 };
-			siv::PerlinNoise perlin3{ seed + 2 };
-			siv::PerlinNoise perlin4{ seed + 3 };
-
-			auto scaledTimer = a_timer * a_config->flickerSpeed;
+			auto noise = SampleFlickerNoise(a_timer * a_config->flickerSpeed, GetFlickerPhase(a_geometry));
 
 			for (int eyeIndex = 0; eyeIndex < eyeCount; eyeIndex++) {
-				light.positionWS[eyeIndex].x += (float)perlin1.noise1D(scaledTimer) * a_config->flickerMovement;
-				light.positionWS[eyeIndex].y += (float)perlin2.noise1D(scaledTimer) * a_config->flickerMovement;
-				light.positionWS[eyeIndex].z += (float)perlin3.noise1D(scaledTimer) * a_config->flickerMovement;
+				light.positionWS[eyeIndex].x += noise.x * a_config->flickerMovement;
+				light.positionWS[eyeIndex].y += noise.y * a_config->flickerMovement;
+				light.positionWS[eyeIndex].z += noise.z * a_config->flickerMovement;
 			}
 
-			light.color.x = std::max(0.0f, light.color.x - ((float)perlin4.noise1D_01(scaledTimer) * a_config->flickerIntensity));
-			light.color.y = std::max(0.0f, light.color.y - ((float)perlin4.noise1D_01(scaledTimer) * a_config->flickerIntensity));
-			light.color.z = std::max(0.0f, light.color.z - ((float)perlin4.noise1D_01(scaledTimer) * a_config->flickerIntensity));
+			float intensity = (noise.w * 0.5f + 0.5f) * a_config->flickerIntensity;
+			light.color.x = std::max(0.0f, light.color.x - intensity);
+			light.color.y = std::max(0.0f, light.color.y - intensity);
+			light.color.z = std::max(0.0f, light.color.z - intensity);
 		}
 
 		CachedParticleLight cachedParticleLight{};
@@ -722,6 +915,31 @@ bool LightLimitFix::AddCachedParticleLights(eastl::vector<LightData>& lightsData
 	return false;
 }
 
+float LightLimitFix::GetParticleLightImportance(const LightData& a_light)
+{
+	// Approximates the screen-space contribution: intensity scaled by the projected radius
+	float intensity = a_light.color.Dot(float3(0.3f, 0.59f, 0.11f));
+	float distance = std::max(a_light.positionWS[0].Length(), 1.0f);
+	return intensity * a_light.radius / distance;
+}
+
+uint32_t LightLimitFix::ApplyParticleLightsBudget(eastl::vector<LightData>& lightsData, size_t a_firstParticleLight)
+{
+	size_t particleLightCount = lightsData.size() - a_firstParticleLight;
+	if (!settings.ParticleLightsBudget || particleLightCount <= settings.ParticleLightsBudget)
+		return 0;
+
+	// Partial selection, only the kept lights need to be ordered in front of the culled ones
+	auto first = lightsData.begin() + a_firstParticleLight;
+	auto nth = first + settings.ParticleLightsBudget;
+	std::nth_element(first, nth, lightsData.end(), [](const LightData& a, const LightData& b) {
+		return GetParticleLightImportance(a) > GetParticleLightImportance(b);
+	});
+	lightsData.erase(nth, lightsData.end());
+
+	return (uint32_t)(particleLightCount - settings.ParticleLightsBudget);
+}
+
 float3 LightLimitFix::Saturation(float3 color, float saturation)
 {
 	float grey = color.Dot(float3(0.3f, 0.59f, 0.11f));
@@ -767,6 +985,14 @@ void LightLimitFix::UpdateLights()
 
 	eastl::vector<LightData> lightsData{};
 
+	auto getElapsedTime = [](high_resolution_clock::time_point& a_start) {
+		auto now = high_resolution_clock::now();
+		float elapsed = duration<float, std::milli>(now - a_start).count();
+		a_start = now;
+		return elapsed;
+	};
+	auto phaseStart = high_resolution_clock::now();
+
 	static float* g_deltaTime = (float*)RELOCATION_ID(523660, 410199).address();  // 2F6B948, 30064C8
 	static double timer = 0;
 	if (!RE::UI::GetSingleton()->GameIsPaused())
@@ -818,17 +1044,38 @@ void LightLimitFix::UpdateLights()
 		}
 	}
 
+	size_t firstParticleLight = lightsData.size();
+	statistics.pointLightsTime = getElapsedTime(phaseStart);
+
 	{
 		std::lock_guard<std::shared_mutex> lk{ cachedParticleLightsMutex };
 		cachedParticleLights.clear();
-
-		LightData clusteredLight{};
-		uint32_t clusteredLights = 0;
+		particleLightClusters.clear();
 
 		auto eyePosition = eyeCount == 1 ?
 		                       state->GetRuntimeData().posAdjust.getEye(0) :
 		                       state->GetVRRuntimeData().posAdjust.getEye(0);
 
+		RE::NiPoint3 eyeOffset{};
+		if (eyeCount == 2)
+			eyeOffset = eyePosition - state->GetVRRuntimeData().posAdjust.getEye(1);
+
+		auto addParticleLight = [&](const float3& a_color, float a_radius, const float3& a_positionWS) {
+			LightData light{};
+			light.color = a_color;
+			light.radius = a_radius;
+			light.positionWS[0] = a_positionWS;
+			light.positionWS[1] = a_positionWS;
+			if (eyeCount == 2) {
+				light.positionWS[1].x += eyeOffset.x;
+				light.positionWS[1].y += eyeOffset.y;
+				light.positionWS[1].z += eyeOffset.z;
+			}
+			currentLightCount += AddCachedParticleLights(lightsData, light);
+		};
+
+		float clusterCellSize = (float)std::max(settings.ParticleLightsOptimisationClusterRadius, 1u);
+
 		for (const auto& particleLight : particleLights) {
 			if (const auto particleSystem = netimmerse_cast<RE::NiParticleSystem*>(particleLight.first);
 				particleSystem && particleSystem->GetParticleRuntimeData().particleData.get()) {
@@ -850,46 +1097,23 @@ void LightLimitFix::UpdateLights()
 
 					RE::NiPoint3 positionWS = initialPosition - eyePosition;
 
-					if (clusteredLights) {
-						auto averageRadius = clusteredLight.radius / (float)clusteredLights;
-						float radiusDiff = abs(averageRadius - radius);
-
-						auto averagePosition = clusteredLight.positionWS[0] / (float)clusteredLights;
-						float positionDiff = positionWS.GetDistance({ averagePosition.x, averagePosition.y, averagePosition.z });
-
-						if ((radiusDiff + positionDiff) > settings.ParticleLightsOptimisationClusterRadius || !settings.EnableParticleLightsOptimization) {
-							clusteredLight.radius /= (float)clusteredLights;
-							clusteredLight.positionWS[0] /= (float)clusteredLights;
-							clusteredLight.positionWS[1] = clusteredLight.positionWS[0];
-							if (eyeCount == 2) {
-								auto offset = eyePosition - state->GetVRRuntimeData().posAdjust.getEye(1);
-								clusteredLight.positionWS[1].x += offset.x / (float)clusteredLights;
-								clusteredLight.positionWS[1].y += offset.y / (float)clusteredLights;
-								clusteredLight.positionWS[1].z += offset.z / (float)clusteredLights;
-							}
-
-							currentLightCount += AddCachedParticleLights(lightsData, clusteredLight);
-
-							clusteredLights = 0;
-							clusteredLight.color = { 0, 0, 0 };
-							clusteredLight.radius = 0;
-							clusteredLight.positionWS[0] = { 0, 0, 0 };
-						}
-					}
-
 					float alpha = particleLight.second.color.alpha * particleData->GetParticlesRuntimeData().color[p].alpha;
 					float3 color;
 					color.x = particleLight.second.color.red * particleData->GetParticlesRuntimeData().color[p].red;
 					color.y = particleLight.second.color.green * particleData->GetParticlesRuntimeData().color[p].green;
 					color.z = particleLight.second.color.blue * particleData->GetParticlesRuntimeData().color[p].blue;
-					clusteredLight.color += Saturation(color, settings.ParticleLightsSaturation) * alpha;
+					color = Saturation(color, settings.ParticleLightsSaturation) * alpha;
 
-					clusteredLight.radius += radius * particleLight.second.config.radiusMult;
-					clusteredLight.positionWS[0].x += positionWS.x;
-					clusteredLight.positionWS[0].y += positionWS.y;
-					clusteredLight.positionWS[0].z += positionWS.z;
+					radius *= particleLight.second.config.radiusMult;
 
-					clusteredLights++;
+					if (!settings.EnableParticleLightsOptimization) {
+						addParticleLight(color, radius, { positionWS.x, positionWS.y, positionWS.z });
+						continue;
+					}
+
+					// Merge every particle which falls into the same world-space cell, independent of emission order
+					auto& cluster = particleLightClusters[ParticleLightClusters::GetKey({ initialPosition.x, initialPosition.y, initialPosition.z }, clusterCellSize)];
+					ParticleLightClusters::Merge(cluster, { color.x, color.y, color.z }, radius, { positionWS.x, positionWS.y, positionWS.z });
 				}
 
 			} else {
@@ -914,20 +1138,18 @@ void LightLimitFix::UpdateLights()
 			}
 		}
 
-		if (clusteredLights) {
-			clusteredLight.radius /= (float)clusteredLights;
-			clusteredLight.positionWS[0] /= (float)clusteredLights;
-			clusteredLight.positionWS[1] = clusteredLight.positionWS[0];
-			if (eyeCount == 2) {
-				auto offset = eyePosition - state->GetVRRuntimeData().posAdjust.getEye(1);
-				clusteredLight.positionWS[1].x += offset.x / (float)clusteredLights;
-				clusteredLight.positionWS[1].y += offset.y / (float)clusteredLights;
-				clusteredLight.positionWS[1].z += offset.z / (float)clusteredLights;
-			}
-			currentLightCount += AddCachedParticleLights(lightsData, clusteredLight);
+		for (const auto& [key, cluster] : particleLightClusters) {
+			auto merged = ParticleLightClusters::Resolve(cluster);
+			addParticleLight({ merged.color.x, merged.color.y, merged.color.z }, merged.radius, { merged.position.x, merged.position.y, merged.position.z });
 		}
+
+		BuildParticleLightsDetectionGrid();
 	}
 
+	particleLightsBudgetCulled = ApplyParticleLightsBudget(lightsData, firstParticleLight);
+	currentLightCount -= particleLightsBudgetCulled;
+	statistics.particleLightsTime = getElapsedTime(phaseStart);
+
 	auto context = RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context;
 
 	{
@@ -965,60 +1187,127 @@ void LightLimitFix::UpdateLights()
 		memcpy_s(mapped.pData, bytes, lightsData.data(), bytes);
 		context->Unmap(lights->resource.get(), 0);
 	}
+	statistics.uploadTime = getElapsedTime(phaseStart);
 
 	{
-		auto projMatrixUnjittered = eyeCount == 1 ? state->GetRuntimeData().cameraData.getEye().projMatrixUnjittered : state->GetVRRuntimeData().cameraData.getEye().projMatrixUnjittered;
-		float fov = atan(1.0f / static_cast<float4x4>(projMatrixUnjittered).m[0][0]) * 2.0f * (180.0f / 3.14159265359f);
+		bool rebuildClusters = false;
+		PerFrameLightCulling perFrameData{};
+		for (int eyeIndex = 0; eyeIndex < eyeCount; eyeIndex++) {
+			auto projMatrixUnjittered = eyeCount == 1 ? state->GetRuntimeData().cameraData.getEye(eyeIndex).projMatrixUnjittered : state->GetVRRuntimeData().cameraData.getEye(eyeIndex).projMatrixUnjittered;
+			perFrameData.InvProjMatrix[eyeIndex] = DirectX::XMMatrixInverse(nullptr, projMatrixUnjittered);
+
+			// The projection covers near, far, fov and the asymmetric VR frustum
+			auto& cache = clusterGridCache[eyeIndex];
+			float4x4 projMatrix = projMatrixUnjittered;
+			bool changed = !cache.valid || fabs(cache.lightsNear - lightsNear) > 1e-4 || fabs(cache.lightsFar - lightsFar) > 1e-4;
+			for (int i = 0; i < 4 && !changed; i++)
+				for (int j = 0; j < 4 && !changed; j++)
+					changed = fabs(cache.projMatrix.m[i][j] - projMatrix.m[i][j]) > 1e-4;
+
+			if (changed) {
+				cache.valid = true;
+				cache.projMatrix = projMatrix;
+				cache.lightsNear = lightsNear;
+				cache.lightsFar = lightsFar;
+				rebuildClusters = true;
+			}
+		}
 
-		static float _near = 0.0f, _far = 0.0f, _fov = 0.0f, _lightsNear = 0.0f, _lightsFar = 0.0f;
-		if (fabs(_near - accumulator->kCamera->GetRuntimeData2().viewFrustum.fNear) > 1e-4 || fabs(_far - accumulator->kCamera->GetRuntimeData2().viewFrustum.fFar) > 1e-4 || fabs(_fov - fov) > 1e-4 || fabs(_lightsNear - lightsNear) > 1e-4 || fabs(_lightsFar - lightsFar) > 1e-4) {
-			PerFrameLightCulling perFrameData{};
-			perFrameData.InvProjMatrix[0] = DirectX::XMMatrixInverse(nullptr, projMatrixUnjittered);
+		if (rebuildClusters) {
 			if (eyeCount == 1)
 				perFrameData.InvProjMatrix[1] = perFrameData.InvProjMatrix[0];
-			else
-				perFrameData.InvProjMatrix[1] = DirectX::XMMatrixInverse(nullptr, state->GetVRRuntimeData().cameraData.getEye(1).projMatrixUnjittered);
 			perFrameData.LightsNear = lightsNear;
 			perFrameData.LightsFar = lightsFar;
 
 			perFrameLightCulling->Update(perFrameData);
 
-			ID3D11Buffer* perframe_cb = perFrameLightCulling->CB();
-			context->CSSetConstantBuffers(0, 1, &perframe_cb);
+			ComputePassGraph::Pass pass;
+			pass.name = "Light Limit Fix Cluster Building";
+			pass.shader = clusterBuildingCS;
+			pass.uavs[0] = clusters->uav.get();
+			pass.constantBuffers[0] = perFrameLightCulling->CB();
+			pass.threadGroupCount[0] = CLUSTER_SIZE_X;
+			pass.threadGroupCount[1] = CLUSTER_SIZE_Y;
+			pass.threadGroupCount[2] = CLUSTER_SIZE_Z * eyeCount;
+			passGraph.AddPass(std::move(pass));
+		}
+	}
 
-			ID3D11UnorderedAccessView* clusters_uav = clusters->uav.get();
-			context->CSSetUnorderedAccessViews(0, 1, &clusters_uav, nullptr);
+	{
+		ComputePassGraph::Pass pass;
+		pass.name = "Light Limit Fix Cluster Culling";
+		pass.shader = clusterCullingCS;
+		pass.srvs[0] = clusters->srv.get();
+		pass.srvs[1] = lights->srv.get();
+		pass.uavs[0] = lightCounter->uav.get();
+		pass.uavs[1] = lightList->uav.get();
+		pass.uavs[2] = lightGrid->uav.get();
+		pass.threadGroupCount[0] = CLUSTER_SIZE_X / 16;
+		pass.threadGroupCount[1] = CLUSTER_SIZE_Y / 16;
+		pass.threadGroupCount[2] = (CLUSTER_SIZE_Z / 4) * eyeCount;
+		passGraph.AddPass(std::move(pass));
+	}
 
-			context->CSSetShader(clusterBuildingCS, nullptr, 0);
-			context->Dispatch(CLUSTER_SIZE_X, CLUSTER_SIZE_Y, CLUSTER_SIZE_Z);
-			context->CSSetShader(nullptr, nullptr, 0);
+	passGraph.Execute();
+	statistics.clusteringTime = getElapsedTime(phaseStart);
 
-			ID3D11UnorderedAccessView* null_uav = nullptr;
-			context->CSSetUnorderedAccessViews(0, 1, &null_uav, nullptr);
+	if (collectStatistics) {
+		ReadbackLightGrid();
+		collectStatistics = false;
+	}
+}
 
-			_near = accumulator->kCamera->GetRuntimeData2().viewFrustum.fNear;
-			_far = accumulator->kCamera->GetRuntimeData2().viewFrustum.fFar;
-			_fov = fov;
-			_lightsNear = lightsNear;
-			_lightsFar = lightsFar;
-		}
+void LightLimitFix::ReadbackLightGrid()
+{
+	auto renderer = RE::BSGraphics::Renderer::GetSingleton();
+	auto device = renderer->GetRuntimeData().forwarder;
+	auto context = renderer->GetRuntimeData().context;
+
+	uint gridSize = CLUSTER_COUNT * eyeCount;
+
+	// Copy this frame's grid into the ring, then read the oldest copy without stalling on the GPU
+	auto& target = lightGridReadback[lightGridReadbackIndex];
+	if (!target) {
+		D3D11_BUFFER_DESC desc{};
+		desc.Usage = D3D11_USAGE_STAGING;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		desc.ByteWidth = sizeof(LightGrid) * gridSize;
+		DX::ThrowIfFailed(device->CreateBuffer(&desc, nullptr, target.put()));
 	}
+	context->CopyResource(target.get(), lightGrid->resource.get());
+	lightGridReadbackPending[lightGridReadbackIndex] = true;
 
-	{
-		ID3D11ShaderResourceView* srvs[] = { clusters->srv.get(), lights->srv.get() };
-		context->CSSetShaderResources(0, ARRAYSIZE(srvs), srvs);
-		ID3D11UnorderedAccessView* uavs[] = { lightCounter->uav.get(), lightList->uav.get(), lightGrid->uav.get() };
-		context->CSSetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs, nullptr);
-
-		context->CSSetShader(clusterCullingCS, nullptr, 0);
-		context->Dispatch(CLUSTER_SIZE_X / 16, CLUSTER_SIZE_Y / 16, CLUSTER_SIZE_Z / 4);
-		context->CSSetShader(nullptr, nullptr, 0);
+	lightGridReadbackIndex = (lightGridReadbackIndex + 1) % LIGHT_GRID_READBACK_LATENCY;
+
+	auto& source = lightGridReadback[lightGridReadbackIndex];
+	if (!lightGridReadbackPending[lightGridReadbackIndex])
+		return;
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	if (FAILED(context->Map(source.get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped)))
+		return;
+
+	statistics.occupancy = {};
+	statistics.maxLightsPerCluster = 0;
+	statistics.saturatedClusters = 0;
+
+	auto grid = reinterpret_cast<const LightGrid*>(mapped.pData);
+	for (uint i = 0; i < gridSize; i++) {
+		uint count = grid[i].lightCount;
+		statistics.maxLightsPerCluster = std::max(statistics.maxLightsPerCluster, count);
+
+		uint bucket;
+		if (count >= CLUSTER_MAX_LIGHTS) {
+			statistics.saturatedClusters++;
+			bucket = LIGHT_GRID_HISTOGRAM_BUCKETS - 1;
+		} else {
+			bucket = count == 0 ? 0 : 1 + count * (LIGHT_GRID_HISTOGRAM_BUCKETS - 2) / CLUSTER_MAX_LIGHTS;
+		}
+		statistics.occupancy[bucket]++;
 	}
 
-	ID3D11ShaderResourceView* null_srvs[2] = { nullptr };
-	context->CSSetShaderResources(0, ARRAYSIZE(null_srvs), null_srvs);
-	ID3D11UnorderedAccessView* null_uavs[3] = { nullptr };
-	context->CSSetUnorderedAccessViews(0, ARRAYSIZE(null_uavs), null_uavs, nullptr);
+	context->Unmap(source.get(), 0);
+	lightGridReadbackPending[lightGridReadbackIndex] = false;
 }
 
 bool LightLimitFix::HasShaderDefine(RE::BSShader::Type shaderType)
@@ -3,11 +3,13 @@
 #include <d3d11.h>
 
 #include "Buffer.h"
+#include "ComputePassGraph.h"
 #include <shared_mutex>
 
 #include "Feature.h"
 #include "ShaderCache.h"
 #include <Features/LightLimitFix/ParticleLights.h>
+#include <Features/LightLimitFix/ParticleLightClusters.h>
 
 struct LightLimitFix : Feature
 {
@@ -79,6 +81,15 @@ public:
 	};
 
 	StrictLightData strictLightDataTemp;
+	StrictLightData strictLightDataUploaded;
+	bool strictLightDataValid = false;
+
+	// Per-draw records are suballocated from one dynamic buffer when the driver allows no-overwrite maps on buffer SRVs
+	bool strictLightDataRing = false;
+	uint32_t strictLightDataRingIndex = 0;
+	eastl::vector<winrt::com_ptr<ID3D11ShaderResourceView>> strictLightDataViews;
+
+	bool StrictLightDataChanged() const;
 
 	struct CachedParticleLight
 	{
@@ -98,6 +109,8 @@ public:
 
 	ConstantBuffer* perFrameLightCulling = nullptr;
 
+	ComputePassGraph passGraph;
+
 	eastl::unique_ptr<Buffer> lights = nullptr;
 	eastl::unique_ptr<Buffer> clusters = nullptr;
 	eastl::unique_ptr<Buffer> lightCounter = nullptr;
@@ -106,17 +119,60 @@ public:
 
 	std::uint32_t lightCount = 0;
 
+	struct ClusterGridCache
+	{
+		bool valid = false;
+		float4x4 projMatrix;
+		float lightsNear = 0.0f;
+		float lightsFar = 0.0f;
+	};
+
+	// Cluster AABBs are only rebuilt when an eye's projection or the lights range changes
+	ClusterGridCache clusterGridCache[2];
+
+	static constexpr uint LIGHT_GRID_READBACK_LATENCY = 3;
+	static constexpr uint LIGHT_GRID_HISTOGRAM_BUCKETS = 10;
+
+	struct Statistics
+	{
+		// Clusters with 0 lights, then 16-light wide buckets, then clusters at the light limit
+		std::array<uint32_t, LIGHT_GRID_HISTOGRAM_BUCKETS> occupancy{};
+		uint32_t maxLightsPerCluster = 0;
+		uint32_t saturatedClusters = 0;
+		float pointLightsTime = 0.0f;
+		float particleLightsTime = 0.0f;
+		float uploadTime = 0.0f;
+		float clusteringTime = 0.0f;
+	};
+
+	Statistics statistics;
+
+	// The light grid is only read back while the statistics are being displayed
+	bool collectStatistics = false;
+	winrt::com_ptr<ID3D11Buffer> lightGridReadback[LIGHT_GRID_READBACK_LATENCY];
+	bool lightGridReadbackPending[LIGHT_GRID_READBACK_LATENCY]{};
+	uint lightGridReadbackIndex = 0;
+
+	void ReadbackLightGrid();
+
 	Texture2D* screenSpaceShadowsTexture = nullptr;
 
 	struct ParticleLightInfo
 	{
 		RE::NiColorA color;
 		ParticleLights::Config& config;
+		RE::NiParticlesData* particleData = nullptr;
 	};
 
+	// Each geometry holds a single reference while it is in either map, carried over from frame to frame
+	std::mutex queuedParticleLightsMutex;
 	eastl::hash_map<RE::BSGeometry*, ParticleLightInfo> queuedParticleLights;
 	eastl::hash_map<RE::BSGeometry*, ParticleLightInfo> particleLights;
 
+	void AcquireParticleLight(RE::BSGeometry* a_geometry, ParticleLightInfo& a_info);
+
+	eastl::hash_map<std::uint64_t, ParticleLightClusters::Cluster> particleLightClusters;
+
 	virtual void SetupResources();
 	virtual void Reset();
 
@@ -132,6 +188,8 @@ public:
 	float CalculateLightDistance(float3 a_lightPosition, float a_radius);
 	bool AddCachedParticleLights(eastl::vector<LightData>& lightsData, LightLimitFix::LightData& light, ParticleLights::Config* a_config = nullptr, RE::BSGeometry* a_geometry = nullptr, double timer = 0.0f);
 	void SetLightPosition(LightLimitFix::LightData& a_light, RE::NiPoint3& a_initialPosition);
+	static float GetParticleLightImportance(const LightData& a_light);
+	uint32_t ApplyParticleLightsBudget(eastl::vector<LightData>& lightsData, size_t a_firstParticleLight);
 	void UpdateLights();
 	void Bind();
 
@@ -153,6 +211,7 @@ public:
 		float ParticleLightsRadiusBillboards = 1.0f;
 		bool EnableParticleLightsOptimization = true;
 		uint ParticleLightsOptimisationClusterRadius = 32;
+		uint ParticleLightsBudget = 1024;
 	};
 
 	float lightsNear = 0.0f;
@@ -162,6 +221,22 @@ public:
 
 	bool CheckParticleLights(RE::BSRenderPass* a_pass, uint32_t a_technique);
 
+	struct CachedVertexColor
+	{
+		const std::uint8_t* colors;
+		uint32_t vertexSize;
+		uint32_t vertexCount;
+		uint32_t lastUsedFrame;
+		RE::NiColorA color;
+	};
+
+	// Max-alpha vertex colour per renderer data, rescanned if its vertex data or layout changes
+	std::mutex vertexColorCacheMutex;
+	eastl::hash_map<const void*, CachedVertexColor> vertexColorCache;
+
+	RE::NiColorA GetCachedVertexColor(const void* a_rendererData, const std::uint8_t* a_colors, uint32_t a_vertexSize, uint32_t a_vertexCount);
+	void PruneVertexColorCache();
+
 	void BSLightingShader_SetupGeometry_Before(RE::BSRenderPass* a_pass);
 
 	enum class Space
@@ -174,11 +249,21 @@ public:
 
 	void BSLightingShader_SetupGeometry_After(RE::BSRenderPass* a_pass);
 
+	struct CachedParticleLightCell
+	{
+		std::uint64_t key;
+		uint32_t index;
+	};
+
 	std::shared_mutex cachedParticleLightsMutex;
 	eastl::vector<CachedParticleLight> cachedParticleLights;
-	uint32_t particleLightsDetectionHits = 0;
+	eastl::vector<CachedParticleLightCell> cachedParticleLightCells;
+	std::atomic<uint32_t> particleLightsDetectionHits = 0;
+	uint32_t particleLightsBudgetCulled = 0;
 
 	float CalculateLuminance(CachedParticleLight& light, RE::NiPoint3& point);
+	static std::uint64_t GetDetectionCellKey(std::int32_t a_x, std::int32_t a_y);
+	void BuildParticleLightsDetectionGrid();
 	void AddParticleLightLuminance(RE::NiPoint3& targetPosition, int& numHits, float& lightLevel);
 
 	struct Hooks
@@ -16,7 +16,11 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
 	NearHardness,
 	BlurRadius,
 	BlurDropoff,
-	Enabled)
+	Enabled,
+	RaymarchScale,
+	TemporalAccumulation,
+	TemporalSamples,
+	TemporalBlend)
 
 void ScreenSpaceShadows::DrawSettings()
 {
@@ -39,6 +43,50 @@ void ScreenSpaceShadows::DrawSettings()
 			ImGui::EndTooltip();
 		}
 
+		{
+			static constexpr const char* scaleNames[] = { "Full", "Half", "Quarter" };
+
+			int current = (int)std::bit_width(settings.RaymarchScale) - 1;
+			if (ImGui::Combo("Raymarch Resolution", &current, scaleNames, (int)ARRAYSIZE(scaleNames)))
+				settings.RaymarchScale = 1u << current;
+			if (ImGui::IsItemHovered()) {
+				ImGui::BeginTooltip();
+				ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+				ImGui::Text("Traces shadows at a reduced resolution and upsamples them along depth edges. Lower resolutions are much faster but lose detail on small objects.");
+				ImGui::PopTextWrapPos();
+				ImGui::EndTooltip();
+			}
+		}
+
+		ImGui::Checkbox("Temporal Accumulation", &settings.TemporalAccumulation);
+		if (ImGui::IsItemHovered()) {
+			ImGui::BeginTooltip();
+			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+			ImGui::Text("Varies the sample positions every frame and blends in the reprojected result of previous frames, so fewer samples reach the same quality.");
+			ImGui::PopTextWrapPos();
+			ImGui::EndTooltip();
+		}
+
+		if (settings.TemporalAccumulation) {
+			ImGui::SliderInt("Temporal Samples", (int*)&settings.TemporalSamples, 1, 64);
+			if (ImGui::IsItemHovered()) {
+				ImGui::BeginTooltip();
+				ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+				ImGui::Text("Samples traced each frame while accumulating, replaces Max Samples.");
+				ImGui::PopTextWrapPos();
+				ImGui::EndTooltip();
+			}
+
+			ImGui::SliderFloat("Temporal Blend", &settings.TemporalBlend, 0.05f, 1.0f);
+			if (ImGui::IsItemHovered()) {
+				ImGui::BeginTooltip();
+				ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+				ImGui::Text("Weight of the current frame. Lower values converge to smoother shadows but react slower to movement.");
+				ImGui::PopTextWrapPos();
+				ImGui::EndTooltip();
+			}
+		}
+
 		ImGui::Spacing();
 		ImGui::Spacing();
 		ImGui::TreePop();
@@ -201,6 +249,10 @@ void ScreenSpaceShadows::ClearShaderCache()
 		verticalBlurProgram->Release();
 		verticalBlurProgram = nullptr;
 	}
+	if (upsampleProgram) {
+		upsampleProgram->Release();
+		upsampleProgram = nullptr;
+	}
 }
 
 ID3D11ComputeShader* ScreenSpaceShadows::GetComputeShader()
@@ -230,6 +282,15 @@ ID3D11ComputeShader* ScreenSpaceShadows::GetComputeShaderVerticalBlur()
 	return verticalBlurProgram;
 }
 
+ID3D11ComputeShader* ScreenSpaceShadows::GetComputeShaderUpsample()
+{
+	if (!upsampleProgram) {
+		logger::debug("Compiling upsampleProgram");
+		upsampleProgram = (ID3D11ComputeShader*)Util::CompileShader(L"Data\\Shaders\\ScreenSpaceShadows\\UpsampleCS.hlsl", {}, "cs_5_0");
+	}
+	return upsampleProgram;
+}
+
 void ScreenSpaceShadows::ModifyLighting(const RE::BSShader*, const uint32_t)
 {
 	if (!loaded)
@@ -292,160 +353,193 @@ void ScreenSpaceShadows::ModifyLighting(const RE::BSShader*, const uint32_t)
 			}
 		}
 
-		auto shadowState = RE::BSGraphics::RendererShadowState::GetSingleton();
-
-		bool enableSSS = true;
-
-		if (shadowState->GetRuntimeData().cubeMapRenderTarget == RE::RENDER_TARGETS_CUBEMAP::kREFLECTIONS) {
-			enableSSS = false;
-
-		} else if (!renderedScreenCamera && settings.Enabled) {
-			renderedScreenCamera = true;
+		uint32_t raymarchScale = std::clamp(settings.RaymarchScale, 1u, 4u);
+		if (raymarchScale > 1 && (!screenSpaceShadowsTextureRaymarch || raymarchTextureScale != raymarchScale)) {
+			logger::debug("Creating screenSpaceShadowsTextureRaymarch");
 
-			// Backup the game state
-			struct OldState
-			{
-				ID3D11ShaderResourceView* srvs[2];
-				ID3D11SamplerState* sampler;
-				ID3D11ComputeShader* shader;
-				ID3D11Buffer* buffer;
-				ID3D11UnorderedAccessView* uav;
-				ID3D11ClassInstance* instance;
-				UINT numInstances;
-			};
-
-			OldState old{};
-			context->CSGetShaderResources(0, 2, old.srvs);
-			context->CSGetSamplers(0, 1, &old.sampler);
-			context->CSGetShader(&old.shader, &old.instance, &old.numInstances);
-			context->CSGetConstantBuffers(0, 1, &old.buffer);
-			context->CSGetUnorderedAccessViews(0, 1, &old.uav);
+			D3D11_TEXTURE2D_DESC texDesc = screenSpaceShadowsTexture->desc;
+			texDesc.Width = (texDesc.Width + raymarchScale - 1) / raymarchScale;
+			texDesc.Height = (texDesc.Height + raymarchScale - 1) / raymarchScale;
+			texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
 
-			{
-				auto viewport = RE::BSGraphics::State::GetSingleton();
+			delete screenSpaceShadowsTextureRaymarch;
+			screenSpaceShadowsTextureRaymarch = new Texture2D(texDesc);
 
-				float resolutionX = screenSpaceShadowsTexture->desc.Width * viewport->GetRuntimeData().dynamicResolutionCurrentWidthScale;
-				float resolutionY = screenSpaceShadowsTexture->desc.Height * viewport->GetRuntimeData().dynamicResolutionCurrentHeightScale;
+			D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+			srvDesc.Format = texDesc.Format;
+			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MipLevels = 1;
+			screenSpaceShadowsTextureRaymarch->CreateSRV(srvDesc);
 
-				{
-					RaymarchCB data{};
+			D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+			uavDesc.Format = texDesc.Format;
+			uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+			uavDesc.Texture2D.MipSlice = 0;
+			screenSpaceShadowsTextureRaymarch->CreateUAV(uavDesc);
 
-					data.BufferDim.x = (float)screenSpaceShadowsTexture->desc.Width;
-					data.BufferDim.y = (float)screenSpaceShadowsTexture->desc.Height;
+			raymarchTextureScale = raymarchScale;
+		}
 
-					data.RcpBufferDim.x = 1.0f / data.BufferDim.x;
-					data.RcpBufferDim.y = 1.0f / data.BufferDim.y;
-					if (REL::Module::IsVR())
-						data.ProjMatrix = shadowState->GetVRRuntimeData().cameraData.getEye().projMat;
-					else
-						data.ProjMatrix = shadowState->GetRuntimeData().cameraData.getEye().projMat;
+		auto& raymarchDesc = raymarchScale > 1 ? screenSpaceShadowsTextureRaymarch->desc : screenSpaceShadowsTexture->desc;
+		if (settings.TemporalAccumulation && (!historyTexture[0] || historyTexture[0]->desc.Width != raymarchDesc.Width || historyTexture[0]->desc.Height != raymarchDesc.Height)) {
+			logger::debug("Creating historyTexture");
+
+			D3D11_TEXTURE2D_DESC texDesc = raymarchDesc;
+			texDesc.Format = DXGI_FORMAT_R32G32_FLOAT;
+			texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+
+			D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+			srvDesc.Format = texDesc.Format;
+			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MipLevels = 1;
+
+			D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+			uavDesc.Format = texDesc.Format;
+			uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+			uavDesc.Texture2D.MipSlice = 0;
+
+			for (auto& history : historyTexture) {
+				delete history;
+				history = new Texture2D(texDesc);
+				history->CreateSRV(srvDesc);
+				history->CreateUAV(uavDesc);
+			}
 
-					data.InvProjMatrix = XMMatrixInverse(nullptr, data.ProjMatrix);
+			historyValid = false;
+		}
 
-					data.DynamicRes.x = viewport->GetRuntimeData().dynamicResolutionCurrentWidthScale;
-					data.DynamicRes.y = viewport->GetRuntimeData().dynamicResolutionCurrentHeightScale;
+		auto shadowState = RE::BSGraphics::RendererShadowState::GetSingleton();
 
-					data.DynamicRes.z = 1.0f / data.DynamicRes.x;
-					data.DynamicRes.w = 1.0f / data.DynamicRes.y;
+		bool enableSSS = true;
 
-					auto& direction = dirLight->GetWorldDirection();
-					DirectX::XMFLOAT3 position{};
-					position.x = -direction.x;
-					position.y = -direction.y;
-					position.z = -direction.z;
-					auto viewMatrix = shadowState->GetRuntimeData().cameraData.getEye().viewMat;
-					if (REL::Module::IsVR())
-						viewMatrix = shadowState->GetVRRuntimeData().cameraData.getEye().viewMat;
+		if (shadowState->GetRuntimeData().cubeMapRenderTarget == RE::RENDER_TARGETS_CUBEMAP::kREFLECTIONS) {
+			enableSSS = false;
 
-					auto invDirLightDirectionWS = XMLoadFloat3(&position);
-					data.InvDirLightDirectionVS = XMVector3TransformCoord(invDirLightDirectionWS, viewMatrix);
+		} else if (!renderedScreenCamera && settings.Enabled) {
+			renderedScreenCamera = true;
 
-					data.ShadowDistance = 10000.0f;
+			auto viewport = RE::BSGraphics::State::GetSingleton();
 
-					data.Settings = settings;
+			float resolutionX = screenSpaceShadowsTexture->desc.Width * viewport->GetRuntimeData().dynamicResolutionCurrentWidthScale;
+			float resolutionY = screenSpaceShadowsTexture->desc.Height * viewport->GetRuntimeData().dynamicResolutionCurrentHeightScale;
 
-					raymarchCB->Update(data);
-				}
-
-				ID3D11Buffer* buffer[1] = { raymarchCB->CB() };
-				context->CSSetConstantBuffers(0, 1, buffer);
+			{
+				RaymarchCB data{};
 
-				context->CSSetSamplers(0, 1, &computeSampler);
+				data.BufferDim.x = (float)screenSpaceShadowsTexture->desc.Width;
+				data.BufferDim.y = (float)screenSpaceShadowsTexture->desc.Height;
 
-				auto depth = renderer->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kPOST_ZPREPASS_COPY];
+				data.RcpBufferDim.x = 1.0f / data.BufferDim.x;
+				data.RcpBufferDim.y = 1.0f / data.BufferDim.y;
+				if (REL::Module::IsVR())
+					data.ProjMatrix = shadowState->GetVRRuntimeData().cameraData.getEye().projMat;
+				else
+					data.ProjMatrix = shadowState->GetRuntimeData().cameraData.getEye().projMat;
 
-				ID3D11ShaderResourceView* view = depth.depthSRV;
-				context->CSSetShaderResources(0, 1, &view);
+				data.InvProjMatrix = XMMatrixInverse(nullptr, data.ProjMatrix);
 
-				ID3D11UnorderedAccessView* uav = screenSpaceShadowsTexture->uav.get();
-				context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+				data.DynamicRes.x = viewport->GetRuntimeData().dynamicResolutionCurrentWidthScale;
+				data.DynamicRes.y = viewport->GetRuntimeData().dynamicResolutionCurrentHeightScale;
 
-				auto shader = GetComputeShader();
-				context->CSSetShader(shader, nullptr, 0);
+				data.DynamicRes.z = 1.0f / data.DynamicRes.x;
+				data.DynamicRes.w = 1.0f / data.DynamicRes.y;
 
-				context->Dispatch((uint32_t)std::ceil(resolutionX / 32.0f), (uint32_t)std::ceil(resolutionY / 32.0f), 1);
+				auto& direction = dirLight->GetWorldDirection();
+				DirectX::XMFLOAT3 position{};
+				position.x = -direction.x;
+				position.y = -direction.y;
+				position.z = -direction.z;
+				auto viewMatrix = shadowState->GetRuntimeData().cameraData.getEye().viewMat;
+				if (REL::Module::IsVR())
+					viewMatrix = shadowState->GetVRRuntimeData().cameraData.getEye().viewMat;
 
-				// Filter
-				{
-					uav = nullptr;
-					context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
-					view = nullptr;
-					context->CSSetShaderResources(1, 1, &view);
+				auto posAdjust = !REL::Module::IsVR() ? shadowState->GetRuntimeData().posAdjust.getEye() : shadowState->GetVRRuntimeData().posAdjust.getEye(0);
 
-					view = screenSpaceShadowsTexture->srv.get();
+				auto invDirLightDirectionWS = XMLoadFloat3(&position);
+				data.InvDirLightDirectionVS = XMVector3TransformCoord(invDirLightDirectionWS, viewMatrix);
 
-					context->CSSetShaderResources(1, 1, &view);
+				data.ShadowDistance = 10000.0f;
 
-					uav = screenSpaceShadowsTextureTemp->uav.get();
-					context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+				data.Settings = settings;
+				data.Settings.RaymarchScale = raymarchScale;
 
-					shader = GetComputeShaderHorizontalBlur();
-					context->CSSetShader(shader, nullptr, 0);
+				if (settings.TemporalAccumulation) {
+					data.Settings.MaxSamples = settings.TemporalSamples;
 
-					context->Dispatch((uint32_t)std::ceil(resolutionX / 64.0f), (uint32_t)std::ceil(resolutionY / 64.0f), 1);
+					// Back to camera-relative world space, shifted by the camera movement, then into the previous frame
+					auto offset = posAdjust - previousPosAdjust;
+					data.ReprojectionMatrix = XMMatrixInverse(nullptr, viewMatrix) * DirectX::XMMatrixTranslation(offset.x, offset.y, offset.z) * previousViewMatrix * previousProjMatrix;
+					// In double, a float product of the raw frame count runs out of fractional precision within hours
+					double frameCount = RE::BSGraphics::State::GetSingleton()->uiFrameCount;
+					data.FrameOffset = (float)std::fmod(frameCount * 0.6180339887498949, 1.0);
+					data.HistoryValid = historyValid;
 				}
 
-				{
-					uav = nullptr;
-					context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
-					view = nullptr;
-					context->CSSetShaderResources(1, 1, &view);
+				previousViewMatrix = viewMatrix;
+				previousProjMatrix = data.ProjMatrix;
+				previousPosAdjust = posAdjust;
 
-					view = screenSpaceShadowsTextureTemp->srv.get();
-
-					context->CSSetShaderResources(1, 1, &view);
+				raymarchCB->Update(data);
+			}
 
-					uav = screenSpaceShadowsTexture->uav.get();
-					context->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
+			auto depth = renderer->GetDepthStencilData().depthStencils[RE::RENDER_TARGETS_DEPTHSTENCIL::kPOST_ZPREPASS_COPY];
 
-					shader = GetComputeShaderVerticalBlur();
-					context->CSSetShader(shader, nullptr, 0);
+			// Every pass reads the depth at t0 with the same constants and sampler
+			ComputePassGraph::Pass common;
+			common.srvs[0] = depth.depthSRV;
+			common.constantBuffers[0] = raymarchCB->CB();
+			common.samplers[0] = computeSampler;
 
-					context->Dispatch((uint32_t)std::ceil(resolutionX / 64.0f), (uint32_t)std::ceil(resolutionY / 64.0f), 1);
+			{
+				auto pass = common;
+				pass.name = "Screen-Space Shadows Raymarch";
+				pass.shader = GetComputeShader();
+				pass.uavs[0] = raymarchScale > 1 ? screenSpaceShadowsTextureRaymarch->uav.get() : screenSpaceShadowsTexture->uav.get();
+				if (settings.TemporalAccumulation) {
+					pass.srvs[2] = historyTexture[historyIndex]->srv.get();
+					historyIndex = 1 - historyIndex;
+					pass.uavs[1] = historyTexture[historyIndex]->uav.get();
 				}
+				pass.threadGroupCount[0] = (uint32_t)std::ceil(resolutionX / (32.0f * raymarchScale));
+				pass.threadGroupCount[1] = (uint32_t)std::ceil(resolutionY / (32.0f * raymarchScale));
+				passGraph.AddPass(std::move(pass));
+			}
+			historyValid = settings.TemporalAccumulation;
+
+			if (raymarchScale > 1) {
+				auto pass = common;
+				pass.name = "Screen-Space Shadows Upsample";
+				pass.shader = GetComputeShaderUpsample();
+				pass.srvs[1] = screenSpaceShadowsTextureRaymarch->srv.get();
+				pass.uavs[0] = screenSpaceShadowsTexture->uav.get();
+				pass.threadGroupCount[0] = (uint32_t)std::ceil(resolutionX / 32.0f);
+				pass.threadGroupCount[1] = (uint32_t)std::ceil(resolutionY / 32.0f);
+				passGraph.AddPass(std::move(pass));
 			}
 
-			// Restore the game state
-			context->CSSetShaderResources(0, 2, old.srvs);
-			for (uint8_t i = 0; i < 2; i++)
-				if (old.srvs[i])
-					old.srvs[i]->Release();
-
-			context->CSSetSamplers(0, 1, &old.sampler);
-			if (old.sampler)
-				old.sampler->Release();
-
-			context->CSSetShader(old.shader, &old.instance, old.numInstances);
-			if (old.shader)
-				old.shader->Release();
+			{
+				auto pass = common;
+				pass.name = "Screen-Space Shadows Horizontal Blur";
+				pass.shader = GetComputeShaderHorizontalBlur();
+				pass.srvs[1] = screenSpaceShadowsTexture->srv.get();
+				pass.uavs[0] = screenSpaceShadowsTextureTemp->uav.get();
+				pass.threadGroupCount[0] = (uint32_t)std::ceil(resolutionX / 64.0f);
+				pass.threadGroupCount[1] = (uint32_t)std::ceil(resolutionY / 64.0f);
+				passGraph.AddPass(std::move(pass));
+			}
 
-			context->CSSetConstantBuffers(0, 1, &old.buffer);
-			if (old.buffer)
-				old.buffer->Release();
+			{
+				auto pass = common;
+				pass.name = "Screen-Space Shadows Vertical Blur";
+				pass.shader = GetComputeShaderVerticalBlur();
+				pass.srvs[1] = screenSpaceShadowsTextureTemp->srv.get();
+				pass.uavs[0] = screenSpaceShadowsTexture->uav.get();
+				pass.threadGroupCount[0] = (uint32_t)std::ceil(resolutionX / 64.0f);
+				pass.threadGroupCount[1] = (uint32_t)std::ceil(resolutionY / 64.0f);
+				passGraph.AddPass(std::move(pass));
+			}
 
-			context->CSSetUnorderedAccessViews(0, 1, &old.uav, nullptr);
-			if (old.uav)
-				old.uav->Release();
+			passGraph.Execute();
 		}
 
 		PerPass data{};
@@ -492,6 +586,9 @@ void ScreenSpaceShadows::Load(json& o_json)
 	if (o_json[GetName()].is_object())
 		settings = o_json[GetName()];
 
+	// The raymarch divides the resolution by a power of two, snap anything else down to full, half or quarter
+	settings.RaymarchScale = std::bit_floor(std::clamp(settings.RaymarchScale, 1u, 4u));
+
 	Feature::Load(o_json);
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Buffer.h"
+#include "ComputePassGraph.h"
 #include "Feature.h"
 
 struct ScreenSpaceShadows : Feature
@@ -29,6 +30,10 @@ struct ScreenSpaceShadows : Feature
 		float BlurRadius = 0.5f;
 		float BlurDropoff = 0.005f;
 		bool Enabled = true;
+		uint32_t RaymarchScale = 1;
+		bool TemporalAccumulation = false;
+		uint32_t TemporalSamples = 8;
+		float TemporalBlend = 0.15f;
 	};
 
 	struct alignas(16) PerPass
@@ -48,6 +53,9 @@ struct ScreenSpaceShadows : Feature
 		DirectX::XMVECTOR InvDirLightDirectionVS;
 		float ShadowDistance = 10000;
 		Settings Settings;
+		DirectX::XMMATRIX ReprojectionMatrix;  // Current view space to the previous frame's clip space
+		float FrameOffset;  // Golden ratio sequence in [0, 1) advanced every frame
+		uint32_t HistoryValid;
 	};
 
 	Settings settings;
@@ -59,11 +67,26 @@ struct ScreenSpaceShadows : Feature
 	Texture2D* screenSpaceShadowsTexture = nullptr;
 	Texture2D* screenSpaceShadowsTextureTemp = nullptr;
 
+	// Raymarch output below full resolution, upsampled into screenSpaceShadowsTexture
+	Texture2D* screenSpaceShadowsTextureRaymarch = nullptr;
+	uint32_t raymarchTextureScale = 1;
+
+	// Visibility and view depth of the previous frames at raymarch resolution, read and written alternately
+	Texture2D* historyTexture[2]{};
+	uint32_t historyIndex = 0;
+	bool historyValid = false;
+	DirectX::XMMATRIX previousViewMatrix;
+	DirectX::XMMATRIX previousProjMatrix;
+	RE::NiPoint3 previousPosAdjust;
+
 	ConstantBuffer* raymarchCB = nullptr;
 	ID3D11ComputeShader* raymarchProgram = nullptr;
 
 	ID3D11ComputeShader* horizontalBlurProgram = nullptr;
 	ID3D11ComputeShader* verticalBlurProgram = nullptr;
+	ID3D11ComputeShader* upsampleProgram = nullptr;
+
+	ComputePassGraph passGraph;
 
 	bool renderedScreenCamera = false;
 
@@ -78,6 +101,7 @@ struct ScreenSpaceShadows : Feature
 	ID3D11ComputeShader* GetComputeShader();
 	ID3D11ComputeShader* GetComputeShaderHorizontalBlur();
 	ID3D11ComputeShader* GetComputeShaderVerticalBlur();
+	ID3D11ComputeShader* GetComputeShaderUpsample();
 
 	void ModifyLighting(const RE::BSShader* shader, const uint32_t descriptor);
 	virtual void Draw(const RE::BSShader* shader, const uint32_t descriptor);
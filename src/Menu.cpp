@@ -5,6 +5,7 @@
 #include <imgui_stdlib.h>
 #include <magic_enum.hpp>
 
+#include "ComputePassGraph.h"
 #include "ShaderCache.h"
 #include "State.h"
 
@@ -429,6 +430,10 @@ void Menu::DrawSettings()
 			}
 			if (ImGui::TreeNodeEx("Statistics", ImGuiTreeNodeFlags_DefaultOpen)) {
 				ImGui::Text(std::format("Shader Compiler : {}", shaderCache.GetShaderStatsString()).c_str());
+				if (ImGui::TreeNode("Compute Passes (GPU)")) {
+					ComputePassGraph::DrawTimings();
+					ImGui::TreePop();
+				}
 				ImGui::TreePop();
 			}
 		}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Buffer.h>
+#include <StateTracker.h>
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 
@@ -29,6 +30,11 @@ public:
 
 	void Draw();
 	void DrawDeferred();
+
+	// Pipeline state touched by features inside DrawDeferred
+	StateTracker::D3D11Context deferredContext;
+	StateTracker deferredState;
+
 	void Reset();
 	void Setup();
 
@@ -0,0 +1,91 @@
+#include "StateTracker.h"
+
+#include <algorithm>
+
+void StateTracker::Begin(Context* a_context)
+{
+	context = a_context;
+	psSrvsSaved = 0;
+	renderTargetsSaved = false;
+}
+
+void StateTracker::ClearPSShaderResources(std::uint32_t a_start, std::uint32_t a_count)
+{
+	if (!context || a_start >= MAX_SRVS)
+		return;
+	a_count = std::min(a_count, MAX_SRVS - a_start);
+
+	// Save each run of slots which has not been saved yet with a single call
+	std::uint32_t slot = a_start;
+	while (slot < a_start + a_count) {
+		if (psSrvsSaved & (1u << slot)) {
+			slot++;
+			continue;
+		}
+		std::uint32_t first = slot;
+		while (slot < a_start + a_count && !(psSrvsSaved & (1u << slot))) {
+			psSrvsSaved |= 1u << slot;
+			slot++;
+		}
+		context->GetPSShaderResources(first, slot - first, psSrvs + first);
+	}
+
+	ID3D11ShaderResourceView* nullSrvs[MAX_SRVS]{};
+	context->SetPSShaderResources(a_start, a_count, nullSrvs);
+}
+
+void StateTracker::ClearRenderTargets()
+{
+	if (!context)
+		return;
+
+	if (!renderTargetsSaved) {
+		context->GetRenderTargets(renderTargets, &depthStencil);
+		renderTargetsSaved = true;
+	}
+
+	ID3D11RenderTargetView* nullViews[MAX_RENDER_TARGETS]{};
+	context->SetRenderTargets(nullViews, nullptr);
+}
+
+void StateTracker::End()
+{
+	if (!context)
+		return;
+
+	// Restore each run of saved slots with a single call
+	std::uint32_t slot = 0;
+	while (slot < MAX_SRVS) {
+		if (!(psSrvsSaved & (1u << slot))) {
+			slot++;
+			continue;
+		}
+		std::uint32_t first = slot;
+		while (slot < MAX_SRVS && (psSrvsSaved & (1u << slot)))
+			slot++;
+		context->SetPSShaderResources(first, slot - first, psSrvs + first);
+	}
+
+	for (auto& srv : psSrvs) {
+		if (srv)
+			context->Release(srv);
+		srv = nullptr;
+	}
+	psSrvsSaved = 0;
+
+	if (renderTargetsSaved) {
+		context->SetRenderTargets(renderTargets, depthStencil);
+
+		for (auto& view : renderTargets) {
+			if (view)
+				context->Release(view);
+			view = nullptr;
+		}
+		if (depthStencil)
+			context->Release(depthStencil);
+		depthStencil = nullptr;
+		renderTargetsSaved = false;
+	}
+
+	context = nullptr;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+struct ID3D11ShaderResourceView;
+struct ID3D11RenderTargetView;
+struct ID3D11DepthStencilView;
+
+// Saves the pipeline slots features clear during their deferred work the first time each slot is touched, then
+// restores exactly those slots. Slots which are never touched are never read back, so invocations where no feature
+// needs the pipeline cleared cost nothing. Only the D3D11Context implementation depends on the device, so the tracking
+// can be tested with any Context.
+class StateTracker
+{
+public:
+	static constexpr std::uint32_t MAX_SRVS = 16;
+	static constexpr std::uint32_t MAX_RENDER_TARGETS = 8;  // D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, checked in StateTrackerD3D11.cpp
+
+	// The bindings the tracker reads and writes, kept behind an interface so the tracking does not depend on a device
+	class Context
+	{
+	public:
+		virtual ~Context() = default;
+
+		virtual void GetPSShaderResources(std::uint32_t a_start, std::uint32_t a_count, ID3D11ShaderResourceView** a_views) = 0;
+		virtual void SetPSShaderResources(std::uint32_t a_start, std::uint32_t a_count, ID3D11ShaderResourceView* const* a_views) = 0;
+		virtual void GetRenderTargets(ID3D11RenderTargetView** a_views, ID3D11DepthStencilView** a_dsv) = 0;
+		virtual void SetRenderTargets(ID3D11RenderTargetView* const* a_views, ID3D11DepthStencilView* a_dsv) = 0;
+
+		// Releases a reference returned by one of the getters
+		virtual void Release(ID3D11ShaderResourceView* a_view) = 0;
+		virtual void Release(ID3D11RenderTargetView* a_view) = 0;
+		virtual void Release(ID3D11DepthStencilView* a_view) = 0;
+	};
+
+	// Forwards to the game's immediate context
+	class D3D11Context : public Context
+	{
+	public:
+		void GetPSShaderResources(std::uint32_t a_start, std::uint32_t a_count, ID3D11ShaderResourceView** a_views) override;
+		void SetPSShaderResources(std::uint32_t a_start, std::uint32_t a_count, ID3D11ShaderResourceView* const* a_views) override;
+		void GetRenderTargets(ID3D11RenderTargetView** a_views, ID3D11DepthStencilView** a_dsv) override;
+		void SetRenderTargets(ID3D11RenderTargetView* const* a_views, ID3D11DepthStencilView* a_dsv) override;
+		void Release(ID3D11ShaderResourceView* a_view) override;
+		void Release(ID3D11RenderTargetView* a_view) override;
+		void Release(ID3D11DepthStencilView* a_view) override;
+	};
+
+	void Begin(Context* a_context);
+	void End();
+
+	/*
+	 * Unbinds pixel shader resources, saving the views bound in slots which were not touched since Begin.
+	 *
+	 * @param a_start First slot to unbind
+	 * @param a_count Number of slots to unbind, clamped to MAX_SRVS
+	 */
+	void ClearPSShaderResources(std::uint32_t a_start, std::uint32_t a_count);
+
+	/*
+	 * Unbinds all render targets and the depth stencil, saving them if they were not touched since Begin.
+	 */
+	void ClearRenderTargets();
+
+private:
+	Context* context = nullptr;
+
+	ID3D11ShaderResourceView* psSrvs[MAX_SRVS]{};
+	std::uint32_t psSrvsSaved = 0;  // One bit per slot
+
+	ID3D11RenderTargetView* renderTargets[MAX_RENDER_TARGETS]{};
+	ID3D11DepthStencilView* depthStencil = nullptr;
+	bool renderTargetsSaved = false;
+};
@@ -0,0 +1,40 @@
+#include "StateTracker.h"
+
+#include <d3d11.h>
+
+static_assert(StateTracker::MAX_RENDER_TARGETS == D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT);
+
+void StateTracker::D3D11Context::GetPSShaderResources(std::uint32_t a_start, std::uint32_t a_count, ID3D11ShaderResourceView** a_views)
+{
+	RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context->PSGetShaderResources(a_start, a_count, a_views);
+}
+
+void StateTracker::D3D11Context::SetPSShaderResources(std::uint32_t a_start, std::uint32_t a_count, ID3D11ShaderResourceView* const* a_views)
+{
+	RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context->PSSetShaderResources(a_start, a_count, a_views);
+}
+
+void StateTracker::D3D11Context::GetRenderTargets(ID3D11RenderTargetView** a_views, ID3D11DepthStencilView** a_dsv)
+{
+	RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context->OMGetRenderTargets(MAX_RENDER_TARGETS, a_views, a_dsv);
+}
+
+void StateTracker::D3D11Context::SetRenderTargets(ID3D11RenderTargetView* const* a_views, ID3D11DepthStencilView* a_dsv)
+{
+	RE::BSGraphics::Renderer::GetSingleton()->GetRuntimeData().context->OMSetRenderTargets(MAX_RENDER_TARGETS, a_views, a_dsv);
+}
+
+void StateTracker::D3D11Context::Release(ID3D11ShaderResourceView* a_view)
+{
+	a_view->Release();
+}
+
+void StateTracker::D3D11Context::Release(ID3D11RenderTargetView* a_view)
+{
+	a_view->Release();
+}
+
+void StateTracker::D3D11Context::Release(ID3D11DepthStencilView* a_view)
+{
+	a_view->Release();
+}
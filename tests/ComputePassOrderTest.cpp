@@ -0,0 +1,153 @@
+// Checks the execution order ComputePassGraph derives from the resources each pass reads and writes.
+//
+// Build and run from the repository root, it only depends on the standard library:
+//   c++ -O2 -std=c++20 -Isrc tests/ComputePassOrderTest.cpp -o ComputePassOrderTest
+//   ComputePassOrderTest
+
+#include <cstdio>
+#include <utility>
+
+#include "ComputePassOrder.h"
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool a_condition, const char* a_description)
+	{
+		if (!a_condition) {
+			std::fprintf(stderr, "FAILED: %s\n", a_description);
+			failures++;
+		}
+	}
+
+	// Only the identity of shaders and resources matters
+	int shaderA, shaderB;
+	int textureA, textureB, textureC, textureD;
+
+	ComputePassOrder::Access MakePass(const void* a_shader, std::vector<const void*> a_reads, std::vector<const void*> a_writes)
+	{
+		return { a_shader, std::move(a_reads), std::move(a_writes) };
+	}
+
+	bool IsOrder(const std::vector<std::size_t>& a_order, std::vector<std::size_t> a_expected)
+	{
+		return a_order == a_expected;
+	}
+
+	void TestDependsOn()
+	{
+		using namespace ComputePassOrder;
+		auto writer = MakePass(&shaderA, {}, { &textureA });
+		auto reader = MakePass(&shaderB, { &textureA }, { &textureB });
+		auto otherWriter = MakePass(&shaderB, {}, { &textureA });
+		auto unrelated = MakePass(&shaderA, { &textureC }, { &textureD });
+
+		Check(DependsOn(reader, writer), "reading a written resource depends on the writer");
+		Check(DependsOn(otherWriter, writer), "writing a written resource depends on the writer");
+		Check(DependsOn(otherWriter, reader), "writing a read resource depends on the reader");
+		Check(!DependsOn(unrelated, writer), "passes without shared resources are independent");
+		Check(!DependsOn(MakePass(&shaderA, { &textureC }, {}), MakePass(&shaderB, { &textureC }, {})), "two readers of the same resource are independent");
+	}
+
+	void TestDependentPasses()
+	{
+		// Independent passes keep the recorded order
+		std::vector<ComputePassOrder::Access> independent = {
+			MakePass(&shaderA, { &textureA }, { &textureB }),
+			MakePass(&shaderB, { &textureA }, { &textureC }),
+			MakePass(nullptr, {}, { &textureD }),
+		};
+		Check(IsOrder(ComputePassOrder::Order(independent), { 0, 1, 2 }), "independent passes keep the recorded order");
+
+		// A pass never moves ahead of a pass whose output it reads, even to join the previous shader
+		std::vector<ComputePassOrder::Access> dependent = {
+			MakePass(&shaderA, {}, { &textureA }),
+			MakePass(&shaderB, { &textureA }, { &textureB }),
+			MakePass(&shaderA, { &textureB }, { &textureC }),
+		};
+		Check(IsOrder(ComputePassOrder::Order(dependent), { 0, 1, 2 }), "a reader of a later output waits for it");
+
+		// A write after a read of the same resource keeps the read first
+		std::vector<ComputePassOrder::Access> writeAfterRead = {
+			MakePass(&shaderA, { &textureA }, { &textureB }),
+			MakePass(&shaderB, {}, { &textureC }),
+			MakePass(&shaderA, {}, { &textureA }),
+		};
+		auto order = ComputePassOrder::Order(writeAfterRead);
+		Check(IsOrder(order, { 0, 2, 1 }), "a write after a read stays after the read");
+
+		Check(ComputePassOrder::Order({}).empty(), "no passes give an empty order");
+	}
+
+	void TestReadAfterWriteChain()
+	{
+		// Recorded in order A -> B -> C -> D, each reading the previous output
+		std::vector<ComputePassOrder::Access> chain = {
+			MakePass(&shaderA, {}, { &textureA }),
+			MakePass(&shaderA, { &textureA }, { &textureB }),
+			MakePass(&shaderA, { &textureB }, { &textureC }),
+			MakePass(&shaderA, { &textureC }, { &textureD }),
+		};
+		Check(IsOrder(ComputePassOrder::Order(chain), { 0, 1, 2, 3 }), "a read after write chain runs in sequence");
+
+		// Two chains interleaved with alternating shaders, each chain stays in sequence
+		std::vector<ComputePassOrder::Access> interleaved = {
+			MakePass(&shaderA, {}, { &textureA }),
+			MakePass(&shaderB, {}, { &textureC }),
+			MakePass(&shaderB, { &textureA }, { &textureB }),
+			MakePass(&shaderA, { &textureC }, { &textureD }),
+		};
+		auto order = ComputePassOrder::Order(interleaved);
+		std::size_t position[4]{};
+		for (std::size_t i = 0; i < order.size(); i++)
+			position[order[i]] = i;
+		Check(order.size() == 4, "every pass is scheduled once");
+		Check(position[0] < position[2], "the first chain stays in sequence");
+		Check(position[1] < position[3], "the second chain stays in sequence");
+	}
+
+	void TestSameShaderGrouping()
+	{
+		// Independent passes alternating between two shaders are grouped by shader
+		std::vector<ComputePassOrder::Access> alternating = {
+			MakePass(&shaderA, {}, { &textureA }),
+			MakePass(&shaderB, {}, { &textureB }),
+			MakePass(&shaderA, {}, { &textureC }),
+			MakePass(&shaderB, {}, { &textureD }),
+		};
+		Check(IsOrder(ComputePassOrder::Order(alternating), { 0, 2, 1, 3 }), "independent passes are grouped by shader");
+
+		// Grouping stops at a dependency and resumes once it is met
+		std::vector<ComputePassOrder::Access> blocked = {
+			MakePass(&shaderA, {}, { &textureA }),
+			MakePass(&shaderB, { &textureA }, { &textureB }),
+			MakePass(&shaderA, { &textureB }, { &textureC }),
+			MakePass(&shaderB, {}, { &textureD }),
+		};
+		Check(IsOrder(ComputePassOrder::Order(blocked), { 0, 1, 3, 2 }), "grouping never skips a dependency");
+
+		// Passes without a shader are never grouped with each other
+		std::vector<ComputePassOrder::Access> noShader = {
+			MakePass(nullptr, {}, { &textureA }),
+			MakePass(&shaderA, {}, { &textureB }),
+			MakePass(nullptr, {}, { &textureC }),
+		};
+		Check(IsOrder(ComputePassOrder::Order(noShader), { 0, 1, 2 }), "passes without a shader keep the recorded order");
+	}
+}
+
+int main()
+{
+	TestDependsOn();
+	TestDependentPasses();
+	TestReadAfterWriteChain();
+	TestSameShaderGrouping();
+
+	if (failures) {
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	std::printf("All compute pass order checks passed\n");
+	return 0;
+}
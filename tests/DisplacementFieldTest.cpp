@@ -0,0 +1,130 @@
+// Checks the CPU reference of the grass displacement field splat and decay against known values.
+//
+// Build and run from the repository root, it only depends on the standard library:
+//   c++ -O2 -std=c++20 -Isrc tests/DisplacementFieldTest.cpp -o DisplacementFieldTest
+//   DisplacementFieldTest
+
+#include <cmath>
+#include <cstdio>
+
+#include "Features/GrassCollision/DisplacementField.h"
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool a_condition, const char* a_description)
+	{
+		if (!a_condition) {
+			std::fprintf(stderr, "FAILED: %s\n", a_description);
+			failures++;
+		}
+	}
+
+	bool Near(float a_value, float a_expected, float a_tolerance = 1e-5f)
+	{
+		return std::fabs(a_value - a_expected) <= a_tolerance;
+	}
+
+	void TestDecay()
+	{
+		using namespace DisplacementField;
+		Check(Near(GetDecay(0.0f, 2.0f), 1.0f), "no time passed keeps the whole trail");
+		Check(Near(GetDecay(2.0f, 2.0f), 0.5f), "one half-life halves the trail");
+		Check(Near(GetDecay(6.0f, 2.0f), 0.125f), "three half-lives leave an eighth");
+
+		// Decay per frame compounds to the same result regardless of the frame rate
+		float decay = 1.0f;
+		for (int i = 0; i < 120; i++)
+			decay *= GetDecay(1.0f / 60.0f, 2.0f);
+		Check(Near(decay, 0.5f, 1e-4f), "two seconds of frames at 60 fps halve the trail");
+	}
+
+	void TestSplat()
+	{
+		using namespace DisplacementField;
+		Sphere sphere{ { 0.0f, 0.0f, 100.0f }, 10.0f };
+
+		auto centre = Splat(sphere, 0.0f, 0.0f);
+		Check(Near(centre.x, 0.0f) && Near(centre.y, 0.0f) && Near(centre.z, -1.0f), "the centre is pushed straight down at full strength");
+
+		// Halfway to the edge smoothstep gives exactly a half
+		auto right = Splat(sphere, 5.0f, 0.0f);
+		Check(Near(right.x, 0.5f) && Near(right.z, -0.5f), "halfway to the right pushes right and down by a half");
+		auto left = Splat(sphere, -5.0f, 0.0f);
+		Check(Near(left.x, -0.5f) && Near(left.z, -0.5f), "halfway to the left pushes left and down by a half");
+
+		// Offsets along y only push down, the sideways push is along x
+		auto front = Splat(sphere, 0.0f, 5.0f);
+		Check(Near(front.x, 0.0f) && Near(front.y, 0.0f) && Near(front.z, -0.5f), "offsets along y only push down");
+
+		// smoothstep(10, 0, 2.5) = 1 - smoothstep(0, 10, 2.5) = 1 - 0.15625
+		auto near = Splat(sphere, 2.5f, 0.0f);
+		Check(Near(near.z, -0.84375f), "a quarter of the way out keeps 0.84375 of the strength");
+
+		auto outside = Splat(sphere, 10.0f, 0.0f);
+		Check(Near(outside.x, 0.0f) && Near(outside.z, 0.0f), "the edge of the sphere has no effect");
+	}
+
+	void TestUpdate()
+	{
+		using namespace DisplacementField;
+		Sphere spheres[] = {
+			{ { 0.0f, 0.0f, 100.0f }, 10.0f },
+			{ { 4.0f, 0.0f, 250.0f }, 20.0f },
+			{ { 500.0f, 0.0f, 0.0f }, 10.0f },  // Out of reach
+		};
+
+		Texel empty;
+		empty.displacement = { 0.0f, 0.0f, 0.0f };
+
+		auto texel = Update(empty, 0.5f, spheres, 3, 0.0f, 0.0f);
+		auto expected0 = Splat(spheres[0], 0.0f, 0.0f);
+		auto expected1 = Splat(spheres[1], 0.0f, 0.0f);
+		Check(Near(texel.displacement.x, expected0.x + expected1.x) && Near(texel.displacement.z, expected0.z + expected1.z), "overlapping spheres add up");
+		Check(Near(texel.contactHeight, 90.0f), "the contact height is the lowest sphere bottom");
+
+		// A weak splat does not replace a stronger fading trail
+		Texel trail;
+		trail.displacement = { 0.0f, 0.0f, -8.0f };
+		trail.contactHeight = 12.0f;
+		auto kept = Update(trail, 0.5f, spheres, 3, 0.0f, 0.0f);
+		Check(Near(kept.displacement.z, -4.0f), "the trail decays");
+		Check(Near(kept.contactHeight, 12.0f), "the trail keeps its own contact height");
+
+		// Once the trail has faded below the fresh contact, the contact wins
+		auto replaced = Update(kept, 0.25f, spheres, 3, 0.0f, 0.0f);
+		Check(Near(replaced.contactHeight, 90.0f), "fresh contact replaces a weaker trail");
+
+		// Spheres without a radius are skipped
+		Sphere disabled[] = { { { 0.0f, 0.0f, 0.0f }, 0.0f } };
+		auto untouched = Update(empty, 1.0f, disabled, 1, 0.0f, 0.0f);
+		Check(Near(untouched.displacement.z, 0.0f) && untouched.contactHeight == NO_CONTACT, "spheres without a radius are skipped");
+	}
+
+	void TestContactRange()
+	{
+		using namespace DisplacementField;
+		Check(IsInContactRange(90.0f, 90.0f), "grass at the contact is affected");
+		Check(IsInContactRange(90.0f - HEIGHT_BELOW_CONTACT, 90.0f), "grass just below the contact is affected");
+		Check(IsInContactRange(90.0f + HEIGHT_ABOVE_CONTACT, 90.0f), "tall grass above the contact is affected");
+		Check(!IsInContactRange(0.0f, 500.0f), "grass under a bridge is not affected");
+		Check(!IsInContactRange(500.0f, 0.0f), "grass on an upper floor is not affected");
+		Check(!IsInContactRange(0.0f, NO_CONTACT), "texels without contact affect nothing");
+	}
+}
+
+int main()
+{
+	TestDecay();
+	TestSplat();
+	TestUpdate();
+	TestContactRange();
+
+	if (failures) {
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	std::printf("All displacement field checks passed\n");
+	return 0;
+}
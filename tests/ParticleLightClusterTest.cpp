@@ -0,0 +1,189 @@
+// Checks the particle light clustering against fixed seeded particle clouds.
+//
+// Build and run from the repository root, it only depends on the standard library:
+//   c++ -O2 -std=c++20 -Isrc tests/ParticleLightClusterTest.cpp -o ParticleLightClusterTest
+//   ParticleLightClusterTest
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "Features/LightLimitFIx/ParticleLightClusters.h"
+
+namespace
+{
+	using namespace ParticleLightClusters;
+
+	int failures = 0;
+
+	void Check(bool a_condition, const char* a_description)
+	{
+		if (!a_condition) {
+			std::fprintf(stderr, "FAILED: %s\n", a_description);
+			failures++;
+		}
+	}
+
+	bool Near(float a_value, float a_expected, float a_tolerance = 1e-3f)
+	{
+		return std::fabs(a_value - a_expected) <= a_tolerance;
+	}
+
+	bool Near(const Float3& a_value, const Float3& a_expected, float a_tolerance = 1e-3f)
+	{
+		return Near(a_value.x, a_expected.x, a_tolerance) && Near(a_value.y, a_expected.y, a_tolerance) && Near(a_value.z, a_expected.z, a_tolerance);
+	}
+
+	struct Particle
+	{
+		Float3 color;
+		float radius;
+		Float3 position;
+	};
+
+	using Clusters = std::unordered_map<std::uint64_t, Cluster>;
+
+	// mt19937 output is specified by the standard, the distributions are not, so the clouds are the same everywhere
+	class Random
+	{
+	public:
+		explicit Random(std::uint32_t a_seed) :
+			engine(a_seed) {}
+
+		float Next(float a_min, float a_max)
+		{
+			return a_min + (a_max - a_min) * (float)(engine() >> 8) * (1.0f / 16777216.0f);
+		}
+
+	private:
+		std::mt19937 engine;
+	};
+
+	// Particles spread uniformly in a box
+	std::vector<Particle> MakeCloud(std::uint32_t a_seed, std::size_t a_count, const Float3& a_min, const Float3& a_max)
+	{
+		Random random(a_seed);
+		std::vector<Particle> particles(a_count);
+		for (auto& particle : particles) {
+			particle.color = { random.Next(0.0f, 1.0f), random.Next(0.0f, 1.0f), random.Next(0.0f, 1.0f) };
+			particle.radius = random.Next(16.0f, 128.0f);
+			particle.position = { random.Next(a_min.x, a_max.x), random.Next(a_min.y, a_max.y), random.Next(a_min.z, a_max.z) };
+		}
+		return particles;
+	}
+
+	Clusters ClusterParticles(const std::vector<Particle>& a_particles, float a_cellSize)
+	{
+		Clusters clusters;
+		for (auto& particle : a_particles)
+			Merge(clusters[GetKey(particle.position, a_cellSize)], particle.color, particle.radius, particle.position);
+		return clusters;
+	}
+
+	void TestKey()
+	{
+		Check(GetKey({ 1.0f, 2.0f, 3.0f }, 64.0f) == GetKey({ 63.0f, 60.0f, 0.0f }, 64.0f), "positions in the same cell share a key");
+		Check(GetKey({ 0.5f, 0.0f, 0.0f }, 64.0f) != GetKey({ -0.5f, 0.0f, 0.0f }, 64.0f), "cells either side of zero differ");
+		Check(GetKey({ -1.0f, 0.0f, 0.0f }, 64.0f) == GetKey({ -63.0f, 0.0f, 0.0f }, 64.0f), "negative positions round down into one cell");
+		Check(GetKey({ 64.0f, 0.0f, 0.0f }, 64.0f) != GetKey({ 0.0f, 64.0f, 0.0f }, 64.0f), "axes do not alias");
+		Check(GetKey({ 0.0f, 64.0f, 0.0f }, 64.0f) != GetKey({ 0.0f, 0.0f, 64.0f }, 64.0f), "axes do not alias");
+
+		// A worldspace spans about a million units, each axis keeps its own bits at a cell size of 1
+		Check(GetKey({ 1048575.0f, 0.0f, 0.0f }, 1.0f) != GetKey({ 0.0f, 1.0f, 0.0f }, 1.0f), "large coordinates stay within their axis");
+		Check(GetKey({ -300000.0f, 0.0f, 0.0f }, 1.0f) != GetKey({ 300000.0f, 0.0f, 0.0f }, 1.0f), "opposite ends of a worldspace differ");
+	}
+
+	void TestSingleCell()
+	{
+		auto particles = MakeCloud(1, 500, { 640.5f, -127.5f, 64.5f }, { 703.5f, -64.5f, 127.5f });
+		auto clusters = ClusterParticles(particles, 64.0f);
+		Check(clusters.size() == 1, "a cloud inside one cell merges into one light");
+
+		Float3 color, position;
+		float radius = 0.0f;
+		for (auto& particle : particles) {
+			color.x += particle.color.x;
+			color.y += particle.color.y;
+			color.z += particle.color.z;
+			radius += particle.radius;
+			position.x += particle.position.x;
+			position.y += particle.position.y;
+			position.z += particle.position.z;
+		}
+
+		auto& cluster = clusters.begin()->second;
+		Check(cluster.count == 500, "every particle is merged");
+		auto light = Resolve(cluster);
+		Check(Near(light.color, color, 1e-2f), "merged colours add up");
+		Check(Near(light.radius, radius / 500.0f), "merged radius is the average");
+		Check(Near(light.position, { position.x / 500.0f, position.y / 500.0f, position.z / 500.0f }), "merged position is the average");
+		Check(light.position.x > 640.0f && light.position.x < 704.0f && light.position.y > -128.0f && light.position.y < -64.0f, "the averaged position stays inside the cell");
+	}
+
+	void TestSeparateClouds()
+	{
+		// Two small clouds far apart and one cloud spread over a 4x4x4 block of cells
+		auto near = MakeCloud(2, 100, { 1.0f, 1.0f, 1.0f }, { 63.0f, 63.0f, 63.0f });
+		auto far = MakeCloud(3, 100, { 10241.0f, 1.0f, 1.0f }, { 10303.0f, 63.0f, 63.0f });
+		auto particles = near;
+		particles.insert(particles.end(), far.begin(), far.end());
+
+		auto clusters = ClusterParticles(particles, 64.0f);
+		Check(clusters.size() == 2, "two clouds in separate cells give two lights");
+		for (auto& [key, cluster] : clusters)
+			Check(cluster.count == 100, "each cloud keeps its own particles");
+
+		auto block = MakeCloud(4, 20000, { 0.0f, 0.0f, 0.0f }, { 255.99f, 255.99f, 255.99f });
+		auto blockClusters = ClusterParticles(block, 64.0f);
+		Check(blockClusters.size() == 64, "a cloud over 4x4x4 cells gives one light per cell");
+
+		std::uint32_t total = 0;
+		for (auto& [key, cluster] : blockClusters)
+			total += cluster.count;
+		Check(total == 20000, "no particle is lost or counted twice");
+
+		// Larger cells merge more
+		Check(ClusterParticles(block, 128.0f).size() == 8, "doubling the cell size merges eight cells into one");
+	}
+
+	void TestOrderIndependence()
+	{
+		auto particles = MakeCloud(5, 2000, { -300.0f, -300.0f, -50.0f }, { 300.0f, 300.0f, 50.0f });
+		auto clusters = ClusterParticles(particles, 100.0f);
+
+		auto reversed = particles;
+		std::reverse(reversed.begin(), reversed.end());
+		auto reversedClusters = ClusterParticles(reversed, 100.0f);
+
+		Check(clusters.size() == reversedClusters.size(), "emission order does not change the number of lights");
+		for (auto& [key, cluster] : clusters) {
+			auto other = reversedClusters.find(key);
+			if (other == reversedClusters.end()) {
+				Check(false, "emission order does not change which cells are lit");
+				continue;
+			}
+			auto light = Resolve(cluster);
+			auto otherLight = Resolve(other->second);
+			Check(cluster.count == other->second.count, "emission order does not change the particles per cell");
+			Check(Near(light.color, otherLight.color) && Near(light.radius, otherLight.radius) && Near(light.position, otherLight.position), "emission order does not change the merged light");
+		}
+	}
+}
+
+int main()
+{
+	TestKey();
+	TestSingleCell();
+	TestSeparateClouds();
+	TestOrderIndependence();
+
+	if (failures) {
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	std::printf("All particle light cluster checks passed\n");
+	return 0;
+}
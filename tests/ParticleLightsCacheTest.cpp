@@ -0,0 +1,219 @@
+// Checks the particle lights config cache against fixture directories: cache hits, invalidation when an ini changes,
+// version mismatches, corrupt files and the merge of parse results in path order.
+//
+// Build and run from the repository root, it only depends on the standard library:
+//   c++ -O2 -std=c++20 -Isrc tests/ParticleLightsCacheTest.cpp -o ParticleLightsCacheTest
+//   ParticleLightsCacheTest
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "Features/LightLimitFIx/ParticleLightsCache.h"
+
+namespace
+{
+	namespace fs = std::filesystem;
+
+	int failures = 0;
+
+	void Check(bool a_condition, const char* a_description)
+	{
+		if (!a_condition) {
+			std::fprintf(stderr, "FAILED: %s\n", a_description);
+			failures++;
+		}
+	}
+
+	// Same shape as ParticleLights::Config, the bool before a float leaves padding in memory
+	struct Config
+	{
+		bool cull = false;
+		float radiusMult = 1.0f;
+		bool flicker = false;
+		float flickerSpeed = 0.0f;
+
+		bool operator==(const Config&) const = default;
+	};
+
+	void WriteConfig(ParticleLightsCache::Writer& a_writer, const Config& a_config)
+	{
+		a_writer.Write(a_config.cull);
+		a_writer.Write(a_config.radiusMult);
+		a_writer.Write(a_config.flicker);
+		a_writer.Write(a_config.flickerSpeed);
+	}
+
+	bool ReadConfig(ParticleLightsCache::Reader& a_reader, Config& a_config)
+	{
+		return a_reader.Read(a_config.cull) && a_reader.Read(a_config.radiusMult) && a_reader.Read(a_config.flicker) && a_reader.Read(a_config.flickerSpeed);
+	}
+
+	struct Configs
+	{
+		std::unordered_map<std::string, Config> byName;
+		std::vector<std::pair<std::string, Config>> patterns;
+	};
+
+	std::string Save(std::uint64_t a_key, const Configs& a_configs)
+	{
+		std::ostringstream stream(std::ios::binary);
+		ParticleLightsCache::Writer writer(stream);
+		ParticleLightsCache::WriteHeader(writer, a_key);
+		ParticleLightsCache::WriteConfigs(writer, a_configs.byName, WriteConfig);
+		ParticleLightsCache::WriteConfigs(writer, a_configs.patterns, WriteConfig);
+		return stream.str();
+	}
+
+	bool Load(const std::string& a_data, std::uint64_t a_key, Configs& a_configs)
+	{
+		std::istringstream stream(a_data, std::ios::binary);
+		ParticleLightsCache::Reader reader(stream);
+		return ParticleLightsCache::ReadHeader(reader, a_key) &&
+		       ParticleLightsCache::ReadConfigs(reader, a_configs.byName, ReadConfig) &&
+		       ParticleLightsCache::ReadConfigs(reader, a_configs.patterns, ReadConfig);
+	}
+
+	// A fresh ParticleLights folder with a Gradients subfolder
+	class Fixture
+	{
+	public:
+		Fixture()
+		{
+			root = fs::temp_directory_path() / "ParticleLightsCacheTest";
+			fs::remove_all(root);
+			fs::create_directories(root / "Gradients");
+		}
+
+		~Fixture()
+		{
+			std::error_code ec;
+			fs::remove_all(root, ec);
+		}
+
+		std::string Write(const std::string& a_name, const std::string& a_contents)
+		{
+			auto path = (root / a_name).string();
+			std::ofstream(path, std::ios::binary | std::ios::trunc) << a_contents;
+			return path;
+		}
+
+		fs::path root;
+	};
+
+	void TestKey()
+	{
+		Fixture fixture;
+		std::vector<std::string> configs = {
+			fixture.Write("candle.ini", "[Light]\nRadiusMult=2.0\n"),
+			fixture.Write("torch.ini", "[Light]\nCull=true\n"),
+		};
+		std::vector<std::string> gradients = { fixture.Write("Gradients/fire.ini", "[Gradient]\nColor=#FF8000\n") };
+
+		auto key = ParticleLightsCache::GetKey(configs, gradients);
+		Check(key == ParticleLightsCache::GetKey(configs, gradients), "unchanged inis give the same key");
+
+		// Same size, only the modification time changes
+		auto time = fs::last_write_time(configs[0]);
+		fs::last_write_time(configs[0], time + std::chrono::hours(1));
+		auto touchedKey = ParticleLightsCache::GetKey(configs, gradients);
+		Check(touchedKey != key, "a newer modification time invalidates the cache");
+		fs::last_write_time(configs[0], time);
+		Check(ParticleLightsCache::GetKey(configs, gradients) == key, "restoring the modification time restores the key");
+
+		// Same modification time, only the size changes
+		fixture.Write("torch.ini", "[Light]\nCull=false\n");
+		auto torchTime = fs::last_write_time(configs[1]);
+		auto resizedKey = ParticleLightsCache::GetKey(configs, gradients);
+		fs::last_write_time(configs[1], torchTime);
+		Check(resizedKey != key, "a different size invalidates the cache");
+
+		auto editedKey = ParticleLightsCache::GetKey(configs, gradients);
+		configs.push_back(fixture.Write("lantern.ini", "[Light]\n"));
+		Check(ParticleLightsCache::GetKey(configs, gradients) != editedKey, "an added ini invalidates the cache");
+		configs.pop_back();
+		Check(ParticleLightsCache::GetKey(configs, gradients) == editedKey, "the same set of inis gives the same key");
+
+		// A config moved into the gradients folder is a different set of inis
+		Check(ParticleLightsCache::GetKey(gradients, configs) != editedKey, "configs and gradients are keyed separately");
+		Check(ParticleLightsCache::GetKey({ configs[1], configs[0] }, gradients) != editedKey, "the path order is part of the key");
+	}
+
+	void TestCache()
+	{
+		Configs configs;
+		configs.byName["candle"] = { false, 2.0f, true, 0.5f };
+		configs.byName["torch"] = { true, 1.0f, false, 0.0f };
+		configs.patterns.push_back({ "fire*", { false, 3.0f, false, 1.0f } });
+		configs.patterns.push_back({ "magic?", { true, 0.5f, true, 2.0f } });
+
+		auto data = Save(42, configs);
+
+		Configs loaded;
+		Check(Load(data, 42, loaded), "a cache written for a key loads for that key");
+		Check(loaded.byName == configs.byName, "configs survive the round trip");
+		Check(loaded.patterns == configs.patterns, "patterns survive the round trip in order");
+
+		Configs stale;
+		Check(!Load(data, 43, stale), "a cache written for other inis is rejected");
+
+		// Fields are written one by one, so the size does not depend on padding: 3 bytes of bools and 2 floats per config
+		std::size_t header = sizeof(std::uint32_t) + sizeof(std::uint64_t);
+		std::size_t config = 2 * sizeof(std::uint8_t) + 2 * sizeof(float);
+		std::size_t names = 4 * sizeof(std::uint32_t) + std::string("candle").size() + std::string("torch").size() + std::string("fire*").size() + std::string("magic?").size();
+		Check(data.size() == header + 2 * sizeof(std::uint32_t) + names + 4 * config, "the cache holds no struct padding");
+
+		// Version mismatch, the rest of the file is valid
+		auto otherVersion = data;
+		std::uint32_t version = ParticleLightsCache::VERSION + 1;
+		otherVersion.replace(0, sizeof(version), reinterpret_cast<const char*>(&version), sizeof(version));
+		Configs mismatched;
+		Check(!Load(otherVersion, 42, mismatched), "a cache written by another version is rejected");
+
+		Configs truncated;
+		Check(!Load(data.substr(0, data.size() - 3), 42, truncated), "a truncated cache is rejected");
+
+		// A bool byte which is neither 0 nor 1 means the cache is corrupt
+		auto corrupt = data;
+		corrupt[header + sizeof(std::uint32_t) + sizeof(std::uint32_t) + (configs.byName.begin()->first.size())] = 7;
+		Configs corrupted;
+		Check(!Load(corrupt, 42, corrupted), "a corrupt cache is rejected");
+	}
+
+	void TestMerge()
+	{
+		using Parsed = ParticleLightsCache::ParsedConfig<Config>;
+		std::vector<Parsed> results(4);
+		results[0] = { "candle", Config{ false, 2.0f, false, 0.0f }, { "candle*" } };
+		results[1] = { "broken", std::nullopt, { "broken*" } };  // Failed to parse
+		results[2] = { "candle", Config{ true, 9.0f, false, 0.0f }, { "candle*", "wax?" } };
+		results[3] = { "torch", Config{ true, 1.0f, false, 0.0f }, {} };
+
+		std::unordered_map<std::string, Config> configs;
+		std::vector<std::pair<std::string, Config>> patterns;
+		ParticleLightsCache::Merge(results, configs, patterns);
+
+		Check(configs.size() == 2, "one config per name");
+		Check(configs["candle"].radiusMult == 2.0f, "the first file for a name wins");
+		Check(configs.find("broken") == configs.end(), "files which failed to parse are skipped");
+		Check(patterns.size() == 3, "patterns of every parsed file are kept");
+		Check(patterns[0].first == "candle*" && patterns[0].second.radiusMult == 2.0f, "patterns keep the path order");
+		Check(patterns[1].first == "candle*" && patterns[1].second.radiusMult == 9.0f, "a later file's pattern follows the earlier one");
+		Check(patterns[2].first == "wax?", "patterns within a file keep their order");
+	}
+}
+
+int main()
+{
+	TestKey();
+	TestCache();
+	TestMerge();
+
+	if (failures) {
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	std::printf("All particle lights cache checks passed\n");
+	return 0;
+}
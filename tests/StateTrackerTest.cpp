@@ -0,0 +1,240 @@
+// Checks that StateTracker only reads back and restores the slots which were cleared, and releases every reference it
+// takes, against a mock context.
+//
+// Build and run from the repository root, it only depends on the standard library:
+//   c++ -O2 -std=c++20 -Isrc tests/StateTrackerTest.cpp src/StateTracker.cpp -o StateTrackerTest
+//   StateTrackerTest
+
+#include <cstdio>
+#include <vector>
+
+#include "StateTracker.h"
+
+// The tracker only passes views around, so the mock defines them as reference counts
+struct ID3D11ShaderResourceView
+{
+	int references = 0;
+};
+
+struct ID3D11RenderTargetView
+{
+	int references = 0;
+};
+
+struct ID3D11DepthStencilView
+{
+	int references = 0;
+};
+
+namespace
+{
+	int failures = 0;
+
+	void Check(bool a_condition, const char* a_description)
+	{
+		if (!a_condition) {
+			std::fprintf(stderr, "FAILED: %s\n", a_description);
+			failures++;
+		}
+	}
+
+	struct Range
+	{
+		std::uint32_t start;
+		std::uint32_t count;
+
+		bool operator==(const Range&) const = default;
+	};
+
+	// Records every call and hands out references like the immediate context does
+	class MockContext : public StateTracker::Context
+	{
+	public:
+		ID3D11ShaderResourceView* srvs[StateTracker::MAX_SRVS]{};
+		ID3D11RenderTargetView* renderTargets[StateTracker::MAX_RENDER_TARGETS]{};
+		ID3D11DepthStencilView* depthStencil = nullptr;
+
+		std::vector<Range> srvGets;
+		std::vector<Range> srvSets;
+		int renderTargetGets = 0;
+		int renderTargetSets = 0;
+
+		void GetPSShaderResources(std::uint32_t a_start, std::uint32_t a_count, ID3D11ShaderResourceView** a_views) override
+		{
+			srvGets.push_back({ a_start, a_count });
+			for (std::uint32_t i = 0; i < a_count; i++) {
+				a_views[i] = srvs[a_start + i];
+				if (a_views[i])
+					a_views[i]->references++;
+			}
+		}
+
+		void SetPSShaderResources(std::uint32_t a_start, std::uint32_t a_count, ID3D11ShaderResourceView* const* a_views) override
+		{
+			srvSets.push_back({ a_start, a_count });
+			for (std::uint32_t i = 0; i < a_count; i++)
+				srvs[a_start + i] = a_views[i];
+		}
+
+		void GetRenderTargets(ID3D11RenderTargetView** a_views, ID3D11DepthStencilView** a_dsv) override
+		{
+			renderTargetGets++;
+			for (std::uint32_t i = 0; i < StateTracker::MAX_RENDER_TARGETS; i++) {
+				a_views[i] = renderTargets[i];
+				if (a_views[i])
+					a_views[i]->references++;
+			}
+			*a_dsv = depthStencil;
+			if (depthStencil)
+				depthStencil->references++;
+		}
+
+		void SetRenderTargets(ID3D11RenderTargetView* const* a_views, ID3D11DepthStencilView* a_dsv) override
+		{
+			renderTargetSets++;
+			for (std::uint32_t i = 0; i < StateTracker::MAX_RENDER_TARGETS; i++)
+				renderTargets[i] = a_views[i];
+			depthStencil = a_dsv;
+		}
+
+		void Release(ID3D11ShaderResourceView* a_view) override { a_view->references--; }
+		void Release(ID3D11RenderTargetView* a_view) override { a_view->references--; }
+		void Release(ID3D11DepthStencilView* a_view) override { a_view->references--; }
+	};
+
+	// A context with a view bound in every slot
+	struct Scene
+	{
+		ID3D11ShaderResourceView srvs[StateTracker::MAX_SRVS];
+		ID3D11RenderTargetView renderTargets[2];
+		ID3D11DepthStencilView depthStencil;
+		MockContext context;
+
+		Scene()
+		{
+			for (std::uint32_t i = 0; i < StateTracker::MAX_SRVS; i++)
+				context.srvs[i] = &srvs[i];
+			context.renderTargets[0] = &renderTargets[0];
+			context.renderTargets[1] = &renderTargets[1];
+			context.depthStencil = &depthStencil;
+		}
+
+		bool IsRestored() const
+		{
+			for (std::uint32_t i = 0; i < StateTracker::MAX_SRVS; i++) {
+				if (context.srvs[i] != &srvs[i])
+					return false;
+			}
+			return context.renderTargets[0] == &renderTargets[0] && context.renderTargets[1] == &renderTargets[1] &&
+			       context.renderTargets[2] == nullptr && context.depthStencil == &depthStencil;
+		}
+
+		bool IsReleased() const
+		{
+			for (auto& srv : srvs) {
+				if (srv.references)
+					return false;
+			}
+			return !renderTargets[0].references && !renderTargets[1].references && !depthStencil.references;
+		}
+	};
+
+	void TestUntouched()
+	{
+		Scene scene;
+		StateTracker tracker;
+		tracker.Begin(&scene.context);
+		tracker.End();
+
+		Check(scene.context.srvGets.empty() && scene.context.srvSets.empty(), "nothing cleared reads back and restores no resources");
+		Check(!scene.context.renderTargetGets && !scene.context.renderTargetSets, "nothing cleared reads back and restores no render targets");
+
+		// Without Begin clearing does nothing
+		tracker.ClearPSShaderResources(0, StateTracker::MAX_SRVS);
+		tracker.ClearRenderTargets();
+		Check(scene.context.srvSets.empty() && !scene.context.renderTargetSets, "clearing outside Begin and End does nothing");
+	}
+
+	void TestOverlappingRuns()
+	{
+		Scene scene;
+		StateTracker tracker;
+		tracker.Begin(&scene.context);
+		tracker.ClearPSShaderResources(2, 3);
+		tracker.ClearPSShaderResources(4, 4);
+		tracker.ClearPSShaderResources(2, 6);
+
+		Check(scene.context.srvGets == std::vector<Range>{ { 2, 3 }, { 5, 3 } }, "only slots which were not saved yet are read back");
+		Check(scene.context.srvs[1] == &scene.srvs[1] && scene.context.srvs[8] == &scene.srvs[8], "slots outside the runs stay bound");
+		Check(!scene.context.srvs[2] && !scene.context.srvs[7], "cleared slots are unbound");
+		Check(scene.srvs[2].references == 1 && scene.srvs[1].references == 0, "a reference is taken once per saved slot");
+
+		scene.context.srvSets.clear();
+		tracker.End();
+		Check(scene.context.srvSets == std::vector<Range>{ { 2, 6 } }, "adjacent saved slots are restored with a single call");
+		Check(scene.IsRestored(), "every cleared slot is restored");
+		Check(scene.IsReleased(), "every reference taken is released");
+	}
+
+	void TestSeparateRuns()
+	{
+		Scene scene;
+		StateTracker tracker;
+		tracker.Begin(&scene.context);
+		tracker.ClearPSShaderResources(0, 2);
+		tracker.ClearPSShaderResources(8, 2);
+		tracker.ClearPSShaderResources(14, 10);  // Clamped to the last two slots
+
+		Check(scene.context.srvGets == std::vector<Range>{ { 0, 2 }, { 8, 2 }, { 14, 2 } }, "each touched run is read back");
+		Check(scene.context.srvSets.back() == Range{ 14, 2 }, "clearing past the last slot is clamped");
+
+		scene.context.srvSets.clear();
+		tracker.End();
+		Check(scene.context.srvSets == std::vector<Range>{ { 0, 2 }, { 8, 2 }, { 14, 2 } }, "only the touched runs are restored");
+		Check(scene.IsRestored(), "every cleared slot is restored");
+		Check(scene.IsReleased(), "every reference taken is released");
+
+		// A second use starts from scratch
+		scene.context.srvGets.clear();
+		tracker.Begin(&scene.context);
+		tracker.ClearPSShaderResources(0, 1);
+		tracker.End();
+		Check(scene.context.srvGets == std::vector<Range>{ { 0, 1 } }, "saved slots are forgotten after End");
+		Check(scene.IsRestored() && scene.IsReleased(), "a second use restores and releases as well");
+	}
+
+	void TestRenderTargets()
+	{
+		Scene scene;
+		StateTracker tracker;
+		tracker.Begin(&scene.context);
+		tracker.ClearRenderTargets();
+		tracker.ClearRenderTargets();
+
+		Check(scene.context.renderTargetGets == 1, "render targets are read back once");
+		Check(scene.context.renderTargetSets == 2, "render targets are unbound on every clear");
+		Check(!scene.context.renderTargets[0] && !scene.context.depthStencil, "render targets and depth stencil are unbound");
+		Check(scene.context.srvGets.empty(), "clearing render targets leaves resources alone");
+
+		tracker.End();
+		Check(scene.context.renderTargetSets == 3, "render targets are restored with a single call");
+		Check(scene.IsRestored(), "render targets and depth stencil are restored");
+		Check(scene.IsReleased(), "every reference taken is released");
+		Check(scene.context.srvSets.empty(), "restoring render targets leaves resources alone");
+	}
+}
+
+int main()
+{
+	TestUntouched();
+	TestOverlappingRuns();
+	TestSeparateRuns();
+	TestRenderTargets();
+
+	if (failures) {
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	std::printf("All state tracker checks passed\n");
+	return 0;
+}
@@ -0,0 +1,190 @@
+// Generates the split-sum BRDF LUT used by Dynamic Cubemaps as a binary asset.
+// Mirrors SpbrdfCS.hlsl in single precision, the output does not depend on the thread count or scheduling.
+//
+// Build and run from anywhere, it only depends on the standard library:
+//   c++ -O2 -std=c++20 BRDFLUTGenerator.cpp -o BRDFLUTGenerator
+//   BRDFLUTGenerator "features/Dynamic Cubemaps/Shaders/DynamicCubemaps/BRDFLUT.bin"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Keep in sync with DynamicCubemaps::BRDFLUTHeader
+	constexpr char MAGIC[4] = { 'B', 'R', 'D', 'F' };
+	constexpr std::uint32_t VERSION = 1;
+	constexpr std::uint32_t SIZE = 256;
+
+	constexpr float PI = 3.141592f;
+	constexpr float TWO_PI = 2 * PI;
+	constexpr float EPSILON = 0.001f;
+
+	constexpr std::uint32_t NUM_SAMPLES = 2048;
+	constexpr float INV_NUM_SAMPLES = 1.0f / float(NUM_SAMPLES);
+
+	struct Header
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t width;
+		std::uint32_t height;
+	};
+
+	struct float3
+	{
+		float x, y, z;
+	};
+
+	float Dot(const float3& a, const float3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	float RadicalInverseVdC(std::uint32_t bits)
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return float(bits) * 2.3283064365386963e-10f;
+	}
+
+	float3 SampleGGX(float u1, float u2, float roughness)
+	{
+		float alpha = roughness * roughness;
+
+		float cosTheta = std::sqrt((1.0f - u2) / (1.0f + (alpha * alpha - 1.0f) * u2));
+		float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+		float phi = TWO_PI * u1;
+
+		return { sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta };
+	}
+
+	float GaSchlickG1(float cosTheta, float k)
+	{
+		return cosTheta / (cosTheta * (1.0f - k) + k);
+	}
+
+	float GaSchlickGGXIBL(float cosLi, float cosLo, float roughness)
+	{
+		float k = (roughness * roughness) / 2.0f;
+		return GaSchlickG1(cosLi, k) * GaSchlickG1(cosLo, k);
+	}
+
+	// Round to nearest even, matching what the GPU stores into an R16G16_FLOAT target
+	std::uint16_t FloatToHalf(float value)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		std::uint32_t sign = (bits >> 16) & 0x8000u;
+		std::int32_t exponent = std::int32_t((bits >> 23) & 0xFFu) - 127 + 15;
+		std::uint32_t mantissa = bits & 0x7FFFFFu;
+
+		if (exponent <= 0) {
+			if (exponent < -10)
+				return std::uint16_t(sign);
+			mantissa |= 0x800000u;
+			std::uint32_t shift = std::uint32_t(14 - exponent);
+			std::uint32_t half = mantissa >> shift;
+			std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+			std::uint32_t midpoint = 1u << (shift - 1);
+			if (remainder > midpoint || (remainder == midpoint && (half & 1u)))
+				half++;
+			return std::uint16_t(sign | half);
+		}
+
+		if (exponent >= 31)
+			return std::uint16_t(sign | 0x7C00u);
+
+		std::uint32_t half = (std::uint32_t(exponent) << 10) | (mantissa >> 13);
+		std::uint32_t remainder = mantissa & 0x1FFFu;
+		if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+			half++;  // A carry into the exponent is still the correctly rounded value
+		return std::uint16_t(sign | half);
+	}
+
+	void IntegrateTexel(std::uint32_t x, std::uint32_t y, std::uint16_t* output)
+	{
+		float cosLo = float(x) / float(SIZE);
+		float roughness = float(y) / float(SIZE);
+
+		cosLo = std::max(cosLo, EPSILON);
+
+		float3 Lo = { std::sqrt(1.0f - cosLo * cosLo), 0.0f, cosLo };
+
+		float DFG1 = 0;
+		float DFG2 = 0;
+
+		for (std::uint32_t i = 0; i < NUM_SAMPLES; ++i) {
+			float3 Lh = SampleGGX(float(i) * INV_NUM_SAMPLES, RadicalInverseVdC(i), roughness);
+
+			float LoLh = Dot(Lo, Lh);
+			float3 Li = { 2.0f * LoLh * Lh.x - Lo.x, 2.0f * LoLh * Lh.y - Lo.y, 2.0f * LoLh * Lh.z - Lo.z };
+
+			float cosLi = Li.z;
+			float cosLh = Lh.z;
+			float cosLoLh = std::max(LoLh, 0.0f);
+
+			if (cosLi > 0.0f) {
+				float G = GaSchlickGGXIBL(cosLi, cosLo, roughness);
+				float Gv = G * cosLoLh / (cosLh * cosLo);
+				float Fc = std::pow(1.0f - cosLoLh, 5.0f);
+
+				DFG1 += (1 - Fc) * Gv;
+				DFG2 += Fc * Gv;
+			}
+		}
+
+		output[0] = FloatToHalf(DFG1 * INV_NUM_SAMPLES);
+		output[1] = FloatToHalf(DFG2 * INV_NUM_SAMPLES);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 2) {
+		std::fprintf(stderr, "Usage: %s <output>\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<std::uint16_t> texels(SIZE * SIZE * 2);
+
+	// Rows are handed out dynamically, every texel is independent so the result does not depend on the thread count
+	std::atomic<std::uint32_t> nextRow = 0;
+	auto worker = [&]() {
+		for (std::uint32_t y = nextRow++; y < SIZE; y = nextRow++)
+			for (std::uint32_t x = 0; x < SIZE; x++)
+				IntegrateTexel(x, y, &texels[(y * SIZE + x) * 2]);
+	};
+
+	std::vector<std::thread> threads(std::max(1u, std::thread::hardware_concurrency()));
+	for (auto& thread : threads)
+		thread = std::thread(worker);
+	for (auto& thread : threads)
+		thread.join();
+
+	Header header{};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.width = SIZE;
+	header.height = SIZE;
+
+	std::ofstream stream(argv[1], std::ios::binary);
+	if (!stream) {
+		std::fprintf(stderr, "Failed to open %s\n", argv[1]);
+		return 1;
+	}
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	stream.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(std::uint16_t));
+
+	return stream ? 0 : 1;
+}